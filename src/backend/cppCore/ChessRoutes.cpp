@@ -1,25 +1,330 @@
-#include "ChessRoutes.h"
+#include "chessRoutes.h"
 #include "stockfishHandler.h"
+#include "fen.h"
+#include "moveGen.h"
 #include "external/json.hpp"
+#include <condition_variable>
+#include <functional>
 #include <iostream>
 
 using json = nlohmann::json;
 
-ChessRoutes::ChessRoutes(const std::string& stockfishPath)
+namespace {
+    const char* resultToString(GameResult result) {
+        switch (result) {
+        case GameResult::WhiteWins: return "1-0";
+        case GameResult::BlackWins: return "0-1";
+        case GameResult::Draw: return "1/2-1/2";
+        default: return "*";
+        }
+    }
+
+    const char* terminationToString(Termination termination) {
+        switch (termination) {
+        case Termination::Checkmate: return "checkmate";
+        case Termination::Stalemate: return "stalemate";
+        case Termination::FiftyMoveRule: return "fiftyMoveRule";
+        case Termination::ThreefoldRepetition: return "threefoldRepetition";
+        case Termination::InsufficientMaterial: return "insufficientMaterial";
+        default: return "none";
+        }
+    }
+
+    const char* wdlToString(SyzygyTablebases::Wdl wdl) {
+        switch (wdl) {
+        case SyzygyTablebases::Wdl::Win: return "win";
+        case SyzygyTablebases::Wdl::CursedWin: return "cursedWin";
+        case SyzygyTablebases::Wdl::BlessedLoss: return "blessedLoss";
+        case SyzygyTablebases::Wdl::Loss: return "loss";
+        default: return "draw";
+        }
+    }
+
+    const char* analysisStatusToString(AnalysisStatus status) {
+        switch (status) {
+        case AnalysisStatus::Queued: return "queued";
+        case AnalysisStatus::Running: return "running";
+        case AnalysisStatus::Done: return "done";
+        case AnalysisStatus::Failed: return "failed";
+        default: return "cancelled";
+        }
+    }
+
+    /**
+     * @brief Adds the evaluation and principal variation from an engine info line.
+     */
+    void writeEngineInfo(const Uci::Info& info, json& j) {
+        j["depth"] = info.depth;
+        j["seldepth"] = info.seldepth;
+        j["multipv"] = info.multipv;
+        if (info.hasScore) {
+            j["score"] = { { info.mate ? "mate" : "cp", info.score } };
+            if (info.bound != Uci::Bound::Exact) {
+                j["score"]["bound"] = info.bound == Uci::Bound::Lower ? "lower" : "upper";
+            }
+        }
+        j["nodes"] = info.nodes;
+        j["nps"] = info.nps;
+        j["hashfull"] = info.hashfull;
+        j["time"] = info.timeMs;
+
+        json pv = json::array();
+        for (int i = 0; i < info.pvLength; i++) {
+            pv.push_back(info.pv[i].toUci());
+        }
+        j["pv"] = pv;
+    }
+
+    const char* const LimitNames[] = { "depth", "movetime", "nodes", "wtime", "btime", "winc", "binc", "deadline" };
+
+    /**
+     * @brief Reads search limits from the JSON fields named in LimitNames (times in ms), keeping the current value of any that are absent.
+     */
+    void readLimits(const json& j, SearchLimits& limits) {
+        // A time or node limit replaces the default depth unless the request also gives one
+        bool timed = j.contains("movetime") || j.contains("nodes") || j.contains("wtime") || j.contains("btime");
+        limits.depth = j.value("depth", timed ? 0 : limits.depth);
+        limits.movetimeMs = j.value("movetime", limits.movetimeMs);
+        limits.nodes = j.value("nodes", limits.nodes);
+        limits.wtimeMs = j.value("wtime", limits.wtimeMs);
+        limits.btimeMs = j.value("btime", limits.btimeMs);
+        limits.wincMs = j.value("winc", limits.wincMs);
+        limits.bincMs = j.value("binc", limits.bincMs);
+        limits.deadlineMs = j.value("deadline", limits.deadlineMs);
+    }
+
+    /**
+     * @brief Reads search limits from query parameters of the same names.
+     */
+    void readLimits(const httplib::Request& req, SearchLimits& limits) {
+        json j = json::object();
+        for (const char* name : LimitNames) {
+            if (req.has_param(name)) {
+                j[name] = std::stoll(req.get_param_value(name));
+            }
+        }
+        readLimits(j, limits);
+    }
+
+    /**
+     * @brief The game's limits for a search whose move is played back at the user, pondering as {"ponder"} says.
+     * @param ponderByDefault Whether to ponder when the request does not say.
+     */
+    SearchLimits playingLimits(const GameSession& session, const json& j, bool ponderByDefault) {
+        SearchLimits limits = session.limits;
+        limits.ponder = j.value("ponder", ponderByDefault);
+        return limits;
+    }
+
+    /// Upper bound on a single long-poll, so clients cannot pin an HTTP thread indefinitely.
+    const int MaxAnalysisWaitMs = 30000;
+
+    /// How long an event stream may stay silent before a keep-alive comment is sent.
+    const std::chrono::seconds StreamHeartbeat(1);
+
+    /**
+     * @brief Server-Sent Events produced by a streaming search, waiting to be written to the client.
+     */
+    struct AnalysisStream {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::string pending;    ///< Formatted events not yet written.
+        bool finished = false;  ///< The last event has been queued.
+
+        void push(const char* event, const json& data, bool last = false) {
+            std::string text = std::string("event: ") + event + "\ndata: " + data.dump() + "\n\n";
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending += text;
+                finished = finished || last;
+            }
+            changed.notify_one();
+        }
+    };
+
+    /**
+     * @brief Writes the stream's events to the client as they are queued, with keep-alives in between.
+     * @param onClose Called when the response ends, whether finished or cut off by the client.
+     */
+    void writeEventStream(httplib::Response& res, std::shared_ptr<AnalysisStream> stream, std::function<void()> onClose) {
+        res.set_header("Cache-Control", "no-cache");
+        res.set_chunked_content_provider("text/event-stream",
+            [stream](std::size_t, httplib::DataSink& sink) {
+                std::string events;
+                bool finished;
+                {
+                    std::unique_lock<std::mutex> lock(stream->mutex);
+                    stream->changed.wait_for(lock, StreamHeartbeat, [&]() { return !stream->pending.empty() || stream->finished; });
+                    events.swap(stream->pending);
+                    finished = stream->finished;
+                }
+
+                // A comment line keeps proxies from timing out, and a failed write means the client has gone
+                if (events.empty()) {
+                    events = ": keep-alive\n\n";
+                }
+                if (!sink.write(events.data(), events.size())) return false;
+                if (finished) {
+                    sink.done();
+                }
+                return true;
+            },
+            [onClose](bool) {
+                onClose();
+            });
+    }
+
+    /// Upper bound on the positions of one batch, so a single request cannot flood the analysis queue.
+    const std::size_t MaxBatchPositions = 1000;
+
+    /**
+     * @brief Progress of a batch analysis, shared by the job callbacks and the HTTP thread streaming it.
+     */
+    struct AnalysisBatch {
+        AnalysisStream stream;
+        std::mutex mutex;           ///< Guards the counters; held while queueing a result so the summary comes last.
+        std::vector<std::string> jobIds;
+        std::size_t remaining = 0;
+        std::size_t completed = 0;
+        std::size_t failed = 0;
+        std::uint64_t nodes = 0;
+        std::chrono::steady_clock::time_point startedAt;
+    };
+
+    /**
+     * @brief Reads the positions of a batch: {"fens": [...]}, or the start and every following position of
+     * {"moves": [...]} played from {"fen"} or the initial position.
+     * @return false with error set if a FEN or move is invalid.
+     */
+    bool readBatchPositions(const json& j, std::vector<std::string>& fens, std::string& error) {
+        Position position;
+        int fullmoveNumber = 1;
+        if (j.contains("fens")) {
+            for (const auto& item : j.at("fens")) {
+                std::string fen = item.get<std::string>();
+                Fen::Error fenError = Fen::parse(fen, position, fullmoveNumber);
+                if (fenError != Fen::Error::None) {
+                    error = "Invalid FEN \"" + fen + "\": " + Fen::errorMessage(fenError);
+                    return false;
+                }
+                fens.push_back(fen);
+            }
+            return true;
+        }
+
+        if (j.contains("fen")) {
+            Fen::Error fenError = Fen::parse(j.at("fen").get<std::string>(), position, fullmoveNumber);
+            if (fenError != Fen::Error::None) {
+                error = std::string("Invalid FEN: ") + Fen::errorMessage(fenError);
+                return false;
+            }
+        }
+        else {
+            position.setStartPosition();
+        }
+
+        char fen[Fen::MaxLength];
+        fens.emplace_back(fen, Fen::write(position, fullmoveNumber, fen));
+        for (const auto& item : j.value("moves", json::array())) {
+            std::string text = item.get<std::string>();
+            Move parsed;
+            Move move;
+            if (!Uci::parseMove(text, parsed)
+                || !MoveGen::findLegalMove(position, parsed.from(), parsed.to(), parsed.promotion(), move)) {
+                error = "Illegal move " + text + " after " + fens.back();
+                return false;
+            }
+            if (position.sideToMove() == Color::Black) {
+                fullmoveNumber++;
+            }
+            position.doMove(move);
+            fens.emplace_back(fen, Fen::write(position, fullmoveNumber, fen));
+        }
+        return true;
+    }
+
+    /**
+     * @brief The game a request targets: "gameId" in the JSON body, then the query string, then the default game.
+     */
+    std::string gameIdFrom(const httplib::Request& req, const json& body = json()) {
+        if (body.is_object() && body.contains("gameId")) {
+            return body.at("gameId").get<std::string>();
+        }
+        if (req.has_param("gameId")) {
+            return req.get_param_value("gameId");
+        }
+        return GameSessionStore::DefaultGameId;
+    }
+
+    /**
+     * @brief Answers 400 if a client-supplied FEN does not describe a legal position.
+     * @return true if the request was rejected.
+     */
+    bool rejectInvalidFen(const std::string& fen, httplib::Response& res) {
+        Position position;
+        int fullmoveNumber;
+        Fen::Error fenError = Fen::parse(fen, position, fullmoveNumber);
+        if (fenError == Fen::Error::None) return false;
+
+        res.status = 400;
+        json error;
+        error["error"] = std::string("Invalid FEN: ") + Fen::errorMessage(fenError);
+        res.set_content(error.dump(), "application/json");
+        return true;
+    }
+}
+
+ChessRoutes::ChessRoutes(const std::string& stockfishPath, int engineCount, const OpeningBook::Settings& book,
+    const SyzygyTablebases::Settings& tablebases, const AnalysisCache::Settings& analysisCache)
     : stockfishPath_(stockfishPath),
-    depth_(12) {
+    analysis_(stockfishPath, engineCount) {
+    StockfishApiHandler::setEngineCount(engineCount);
 
-    chessValidator_ = ChessValidator();
-    fen_ = chessValidator_.getBoardAsFen();
+    if (!analysisCache.path.empty()) {
+        if (StockfishApiHandler::openAnalysisCache(analysisCache)) {
+            std::cout << "Analysis cache " << analysisCache.path << ": "
+                << StockfishApiHandler::getAnalysisCache().capacity() << " slots" << std::endl;
+        }
+        else {
+            std::cerr << "Could not open analysis cache " << analysisCache.path << std::endl;
+        }
+    }
+
+    if (!book.path.empty()) {
+        if (book_.open(book)) {
+            std::cout << "Opening book " << book.path << ": " << book_.size() << " entries" << std::endl;
+        }
+        else {
+            std::cerr << "Could not open opening book " << book.path << std::endl;
+        }
+    }
+
+    if (!tablebases.path.empty()) {
+        if (tablebases_.open(tablebases)) {
+            std::cout << "Syzygy tablebases " << tablebases.path << ": " << tablebases_.size()
+                << " tables, up to " << tablebases_.maxPieces() << " pieces" << std::endl;
+        }
+        else {
+            std::cerr << "No Syzygy tablebases found in " << tablebases.path << std::endl;
+        }
+    }
 }
 
 void ChessRoutes::add_cors_headers(httplib::Response& res) {
     res.set_header("Access-Control-Allow-Origin", "*");
-    res.set_header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+    res.set_header("Access-Control-Allow-Methods", "GET, POST, DELETE, OPTIONS");
     res.set_header("Access-Control-Allow-Headers", "Content-Type");
 }
 
 void ChessRoutes::registerRoutes(httplib::Server& svr) {
+    svr.Post("/games", [this](const httplib::Request& req, httplib::Response& res) {
+        handle_create_game(req, res);
+        });
+
+    svr.Delete("/games/:id", [this](const httplib::Request& req, httplib::Response& res) {
+        handle_delete_game(req, res);
+        });
+
     svr.Post("/validate-move", [this](const httplib::Request& req, httplib::Response& res) {
         handle_validate_move(req, res);
         });
@@ -32,6 +337,14 @@ void ChessRoutes::registerRoutes(httplib::Server& svr) {
         handle_legal_moves(req, res);
         });
 
+    svr.Post("/undo", [this](const httplib::Request& req, httplib::Response& res) {
+        handle_undo(req, res);
+        });
+
+    svr.Post("/goto-ply", [this](const httplib::Request& req, httplib::Response& res) {
+        handle_goto_ply(req, res);
+        });
+
     // Stockfish endpoints
     svr.Post("/", [this](const httplib::Request& req, httplib::Response& res) {
         handle_stockfish_post(req, res);
@@ -41,7 +354,42 @@ void ChessRoutes::registerRoutes(httplib::Server& svr) {
         handle_stockfish_get(req, res);
         });
 
+    svr.Post("/analysis", [this](const httplib::Request& req, httplib::Response& res) {
+        handle_analysis_submit(req, res);
+        });
+
+    // Registered before /analysis/:id so "stream" is not taken for a job id
+    svr.Get("/analysis/stream", [this](const httplib::Request& req, httplib::Response& res) {
+        handle_analysis_stream(req, res);
+        });
+
+    svr.Post("/analysis/batch", [this](const httplib::Request& req, httplib::Response& res) {
+        handle_analysis_batch(req, res);
+        });
+
+    svr.Get("/analysis/:id", [this](const httplib::Request& req, httplib::Response& res) {
+        handle_analysis_get(req, res);
+        });
+
+    svr.Delete("/analysis/:id", [this](const httplib::Request& req, httplib::Response& res) {
+        handle_analysis_cancel(req, res);
+        });
+
+    svr.Get("/cache-stats", [this](const httplib::Request& req, httplib::Response& res) {
+        handle_cache_stats(req, res);
+        });
+
     // Register OPTIONS routes for CORS
+    svr.Options("/games", [](const httplib::Request&, httplib::Response& res) {
+        add_cors_headers(res);
+        res.status = 204;
+        });
+
+    svr.Options("/games/:id", [](const httplib::Request&, httplib::Response& res) {
+        add_cors_headers(res);
+        res.status = 204;
+        });
+
     svr.Options("/validate-move", [](const httplib::Request&, httplib::Response& res) {
         add_cors_headers(res);
         res.status = 204;
@@ -57,23 +405,150 @@ void ChessRoutes::registerRoutes(httplib::Server& svr) {
         res.status = 204;
         });
 
+    svr.Options("/undo", [](const httplib::Request&, httplib::Response& res) {
+        add_cors_headers(res);
+        res.status = 204;
+        });
+
+    svr.Options("/goto-ply", [](const httplib::Request&, httplib::Response& res) {
+        add_cors_headers(res);
+        res.status = 204;
+        });
+
+    svr.Options("/analysis", [](const httplib::Request&, httplib::Response& res) {
+        add_cors_headers(res);
+        res.status = 204;
+        });
+
+    svr.Options("/analysis/:id", [](const httplib::Request&, httplib::Response& res) {
+        add_cors_headers(res);
+        res.status = 204;
+        });
+
     svr.Options("/", [](const httplib::Request&, httplib::Response& res) {
         add_cors_headers(res);
         res.status = 204;
         });
 }
 
+std::shared_ptr<GameSession> ChessRoutes::find_session(const std::string& gameId, httplib::Response& res) {
+    auto session = sessions_.find(gameId);
+    if (!session) {
+        res.status = 404;
+        json error;
+        error["error"] = "Unknown game: " + gameId;
+        res.set_content(error.dump(), "application/json");
+    }
+    return session;
+}
+
+bool ChessRoutes::find_reply(GameSession& session, const std::string& gameId, const SearchLimits& limits) {
+    Position position;
+    int fullmoveNumber;
+    bool parsed = (book_.isOpen() || tablebases_.isOpen())
+        && Fen::parse(session.fen, position, fullmoveNumber) == Fen::Error::None;
+
+    Move tablebaseMove;
+    SyzygyTablebases::Wdl wdl;
+    int dtz;
+    if (parsed && tablebases_.probeRoot(position, tablebaseMove, wdl, dtz)) {
+        // A table lookup is exact, so the engine is not needed for this game now
+        StockfishApiHandler::stopPondering(gameId);
+        session.bestmove = tablebaseMove.toUci();
+        return true;
+    }
+
+    Move bookMove;
+    if (parsed && book_.isOpen()) {
+        int ply = 2 * (fullmoveNumber - 1) + (position.sideToMove() == Color::Black ? 1 : 0);
+        if (book_.probe(position, ply, bookMove)) {
+            // Nothing the engine may be pondering for this game will be asked for while the game is in book
+            StockfishApiHandler::stopPondering(gameId);
+            session.bestmove = bookMove.toUci();
+            return true;
+        }
+    }
+
+    std::string bestmove;
+    if (!StockfishApiHandler::getBestMoveFromStockfish(stockfishPath_, session.fen, limits, bestmove, gameId, session.enginePosition)) return false;
+    session.bestmove = bestmove;
+    return true;
+}
+
+void ChessRoutes::handle_create_game(const httplib::Request& req, httplib::Response& res) {
+    add_cors_headers(res);
+
+    try {
+        auto session = std::make_shared<GameSession>();
+        if (!req.body.empty()) {
+            auto j = json::parse(req.body);
+            if (j.contains("fen")) {
+                Fen::Error fenError;
+                if (!session->chessValidator.setBoardFromFen(j.at("fen").get<std::string>(), &fenError)) {
+                    res.status = 400;
+                    json error;
+                    error["error"] = std::string("Invalid FEN: ") + Fen::errorMessage(fenError);
+                    res.set_content(error.dump(), "application/json");
+                    return;
+                }
+            }
+            readLimits(j, session->limits);
+        }
+        session->followBoard();
+        session->publishSnapshot();
+
+        json response;
+        response["gameId"] = sessions_.create(session);
+        write_history_state(*session, response);
+
+        res.status = 201;
+        res.set_content(response.dump(), "application/json");
+    }
+    catch (const std::exception& e) {
+        res.status = 400;
+        json error;
+        error["error"] = std::string("Bad request: ") + e.what();
+        res.set_content(error.dump(), "application/json");
+    }
+}
+
+void ChessRoutes::handle_delete_game(const httplib::Request& req, httplib::Response& res) {
+    add_cors_headers(res);
+
+    std::string gameId = req.path_params.at("id");
+    if (gameId == GameSessionStore::DefaultGameId) {
+        res.status = 400;
+        res.set_content("{\"error\":\"The default game cannot be deleted\"}", "application/json");
+        return;
+    }
+
+    StockfishApiHandler::stopSearches(gameId);
+    StockfishApiHandler::stopPondering(gameId);
+    if (!sessions_.erase(gameId)) {
+        find_session(gameId, res);
+        return;
+    }
+    res.status = 204;
+}
+
 void ChessRoutes::handle_stockfish_post(const httplib::Request& req, httplib::Response& res) {
     add_cors_headers(res);
-    std::lock_guard<std::mutex> lock(mutex_);
     try {
         auto j = json::parse(req.body);
-        fen_ = j.at("fen").get<std::string>();
-        depth_ = j.value("depth", 16);
+        std::string gameId = gameIdFrom(req, j);
+        auto session = find_session(gameId, res);
+        if (!session) return;
+
+        // The new position supersedes any search still running for the game
+        StockfishApiHandler::stopSearches(gameId);
 
-        std::string bestmove;
-        if (StockfishApiHandler::getBestMoveFromStockfish(stockfishPath_, fen_, depth_, bestmove)) {
-            bestmove_ = bestmove;
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->fen = j.at("fen").get<std::string>();
+        session->enginePosition = "fen " + session->fen;
+        session->limits = SearchLimits{ 16 };
+        readLimits(j, session->limits);
+
+        if (find_reply(*session, gameId, playingLimits(*session, j, true))) {
             res.set_content("{\"status\":\"ok\"}", "application/json");
         }
         else {
@@ -87,15 +562,17 @@ void ChessRoutes::handle_stockfish_post(const httplib::Request& req, httplib::Re
     }
 }
 
-void ChessRoutes::handle_stockfish_get(const httplib::Request&, httplib::Response& res) {
+void ChessRoutes::handle_stockfish_get(const httplib::Request& req, httplib::Response& res) {
     add_cors_headers(res);
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::string gameId = gameIdFrom(req);
+    auto session = find_session(gameId, res);
+    if (!session) return;
+
+    std::lock_guard<std::mutex> lock(session->mutex);
     json j;
 
-    std::string bestmove;
-    if (StockfishApiHandler::getBestMoveFromStockfish(stockfishPath_, fen_, depth_, bestmove)) {
-        bestmove_ = bestmove;
-        j["bestmove"] = bestmove_;
+    if (find_reply(*session, gameId, session->limits)) {
+        j["bestmove"] = session->bestmove;
         res.set_content(j.dump(), "application/json");
     }
     else {
@@ -104,12 +581,298 @@ void ChessRoutes::handle_stockfish_get(const httplib::Request&, httplib::Respons
     }
 }
 
+void ChessRoutes::handle_cache_stats(const httplib::Request&, httplib::Response& res) {
+    add_cors_headers(res);
+    const BestMoveCache& cache = StockfishApiHandler::getCache();
+
+    json response;
+    response["hits"] = cache.hits();
+    response["misses"] = cache.misses();
+    response["size"] = cache.size();
+    response["capacity"] = cache.capacity();
+
+    const AnalysisCache& persistent = StockfishApiHandler::getAnalysisCache();
+    if (persistent.isOpen()) {
+        json disk;
+        disk["hits"] = persistent.hits();
+        disk["misses"] = persistent.misses();
+        disk["capacity"] = persistent.capacity();
+        response["persistent"] = disk;
+    }
+
+    res.set_content(response.dump(), "application/json");
+}
+
+void ChessRoutes::handle_analysis_submit(const httplib::Request& req, httplib::Response& res) {
+    add_cors_headers(res);
+
+    try {
+        auto j = json::parse(req.body);
+        std::string fen;
+        std::string gameId;
+        SearchLimits limits{ 16 };
+
+        if (j.contains("fen")) {
+            fen = j.at("fen").get<std::string>();
+            if (rejectInvalidFen(fen, res)) return;
+            gameId = j.value("gameId", "");
+        }
+        else {
+            gameId = gameIdFrom(req, j);
+            auto session = find_session(gameId, res);
+            if (!session) return;
+
+            std::lock_guard<std::mutex> lock(session->mutex);
+            fen = session->fen;
+            limits = session->limits;
+        }
+        readLimits(j, limits);
+
+        json response;
+        response["jobId"] = analysis_.submit(fen, limits, gameId);
+        response["status"] = analysisStatusToString(AnalysisStatus::Queued);
+
+        res.status = 202;
+        res.set_content(response.dump(), "application/json");
+    }
+    catch (const std::exception& e) {
+        res.status = 400;
+        json error;
+        error["error"] = std::string("Bad request: ") + e.what();
+        res.set_content(error.dump(), "application/json");
+    }
+}
+
+void ChessRoutes::handle_analysis_get(const httplib::Request& req, httplib::Response& res) {
+    add_cors_headers(res);
+
+    try {
+        int timeoutMs = req.has_param("timeout") ? std::stoi(req.get_param_value("timeout")) : 0;
+        timeoutMs = timeoutMs < 0 ? 0 : (timeoutMs > MaxAnalysisWaitMs ? MaxAnalysisWaitMs : timeoutMs);
+
+        AnalysisJobInfo info;
+        if (!analysis_.wait(req.path_params.at("id"), std::chrono::milliseconds(timeoutMs), info)) {
+            res.status = 404;
+            res.set_content("{\"error\":\"Unknown analysis job\"}", "application/json");
+            return;
+        }
+
+        json response;
+        response["jobId"] = info.id;
+        response["status"] = analysisStatusToString(info.status);
+        response["fen"] = info.fen;
+        response["depth"] = info.limits.depth;
+        if (info.status == AnalysisStatus::Done) {
+            response["bestmove"] = info.bestmove;
+            response["stopped"] = info.stopped;
+            if (!info.ponder.empty()) {
+                response["ponder"] = info.ponder;
+            }
+            if (info.principal.pvLength > 0) {
+                writeEngineInfo(info.principal, response["analysis"]);
+            }
+        }
+
+        res.set_content(response.dump(), "application/json");
+    }
+    catch (const std::exception& e) {
+        res.status = 400;
+        json error;
+        error["error"] = std::string("Bad request: ") + e.what();
+        res.set_content(error.dump(), "application/json");
+    }
+}
+
+void ChessRoutes::handle_analysis_stream(const httplib::Request& req, httplib::Response& res) {
+    add_cors_headers(res);
+
+    std::string fen;
+    std::string gameId;
+    SearchLimits limits{ 16 };
+    try {
+        if (req.has_param("fen")) {
+            fen = req.get_param_value("fen");
+            if (rejectInvalidFen(fen, res)) return;
+            gameId = req.has_param("gameId") ? req.get_param_value("gameId") : "";
+        }
+        else {
+            gameId = gameIdFrom(req);
+            auto session = find_session(gameId, res);
+            if (!session) return;
+
+            std::lock_guard<std::mutex> lock(session->mutex);
+            fen = session->fen;
+            limits = session->limits;
+        }
+        readLimits(req, limits);
+    }
+    catch (const std::exception& e) {
+        res.status = 400;
+        json error;
+        error["error"] = std::string("Bad request: ") + e.what();
+        res.set_content(error.dump(), "application/json");
+        return;
+    }
+
+    // The search runs on an analysis worker, like any other job, and queues events; the HTTP thread only writes them out
+    auto stream = std::make_shared<AnalysisStream>();
+    std::string jobId = analysis_.submit(fen, limits, gameId,
+        [stream](const AnalysisJobInfo& info) {
+            json final;
+            if (info.status == AnalysisStatus::Done) {
+                final["bestmove"] = info.bestmove;
+                if (!info.ponder.empty()) {
+                    final["ponder"] = info.ponder;
+                }
+                final["cached"] = info.cached;
+                final["stopped"] = info.stopped;
+                stream->push("bestmove", final, true);
+            }
+            else {
+                final["error"] = info.status == AnalysisStatus::Cancelled ? "Search stopped" : "Stockfish failed";
+                stream->push("error", final, true);
+            }
+        },
+        [stream](const Uci::Info& info) {
+            if (info.pvLength == 0) return;
+            json update;
+            writeEngineInfo(info, update);
+            stream->push("info", update);
+        });
+
+    writeEventStream(res, stream, [this, jobId]() {
+        // Stop the engine if the client left mid-search; a no-op once the search is over
+        analysis_.cancel(jobId);
+        });
+}
+
+void ChessRoutes::handle_analysis_batch(const httplib::Request& req, httplib::Response& res) {
+    add_cors_headers(res);
+
+    std::vector<std::string> fens;
+    SearchLimits limits{ 16 };
+    try {
+        auto j = json::parse(req.body);
+        std::string error;
+        if (!readBatchPositions(j, fens, error)) {
+            res.status = 400;
+            json response;
+            response["error"] = error;
+            res.set_content(response.dump(), "application/json");
+            return;
+        }
+        if (fens.empty() || fens.size() > MaxBatchPositions) {
+            res.status = 400;
+            json response;
+            response["error"] = "A batch needs 1 to " + std::to_string(MaxBatchPositions) + " positions";
+            res.set_content(response.dump(), "application/json");
+            return;
+        }
+        readLimits(j, limits);
+    }
+    catch (const std::exception& e) {
+        res.status = 400;
+        json error;
+        error["error"] = std::string("Bad request: ") + e.what();
+        res.set_content(error.dump(), "application/json");
+        return;
+    }
+
+    auto batch = std::make_shared<AnalysisBatch>();
+    batch->remaining = fens.size();
+    batch->startedAt = std::chrono::steady_clock::now();
+    int engines = analysis_.workerCount();
+
+    json start;
+    start["positions"] = fens.size();
+    start["engines"] = engines;
+    batch->stream.push("start", start);
+
+    // Without a game id the positions carry no engine affinity, so every idle worker takes the next one
+    for (std::size_t i = 0; i < fens.size(); i++) {
+        std::string jobId = analysis_.submit(fens[i], limits, std::string(), [batch, i, engines](const AnalysisJobInfo& info) {
+            json result;
+            result["index"] = i;
+            result["fen"] = info.fen;
+            result["status"] = analysisStatusToString(info.status);
+            if (info.status == AnalysisStatus::Done) {
+                result["bestmove"] = info.bestmove;
+                if (!info.ponder.empty()) {
+                    result["ponder"] = info.ponder;
+                }
+                result["cached"] = info.cached;
+                result["stopped"] = info.stopped;
+                if (info.principal.pvLength > 0) {
+                    writeEngineInfo(info.principal, result["analysis"]);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            if (info.status == AnalysisStatus::Done) {
+                batch->completed++;
+                batch->nodes += info.principal.nodes;
+            }
+            else {
+                batch->failed++;
+            }
+            batch->stream.push("result", result);
+            if (--batch->remaining > 0) return;
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - batch->startedAt);
+            double seconds = elapsed.count() > 0 ? elapsed.count() / 1000.0 : 0.001;
+            json summary;
+            summary["positions"] = batch->completed + batch->failed;
+            summary["completed"] = batch->completed;
+            summary["failed"] = batch->failed;
+            summary["engines"] = engines;
+            summary["elapsedMs"] = elapsed.count();
+            summary["positionsPerSecond"] = (batch->completed + batch->failed) / seconds;
+            summary["nodes"] = batch->nodes;
+            summary["nps"] = static_cast<std::uint64_t>(batch->nodes / seconds);
+            batch->stream.push("summary", summary, true);
+            });
+
+        std::lock_guard<std::mutex> lock(batch->mutex);
+        batch->jobIds.push_back(jobId);
+    }
+
+    AnalysisService* analysis = &analysis_;
+    writeEventStream(res, std::shared_ptr<AnalysisStream>(batch, &batch->stream), [batch, analysis]() {
+        // Drop whatever is still queued or running if the client left; finished jobs are unaffected
+        std::vector<std::string> jobIds;
+        {
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            if (batch->remaining == 0) return;
+            jobIds = batch->jobIds;
+        }
+        for (const auto& jobId : jobIds) {
+            analysis->cancel(jobId);
+        }
+        });
+}
+
+void ChessRoutes::handle_analysis_cancel(const httplib::Request& req, httplib::Response& res) {
+    add_cors_headers(res);
+
+    if (!analysis_.cancel(req.path_params.at("id"))) {
+        res.status = 404;
+        res.set_content("{\"error\":\"Unknown analysis job\"}", "application/json");
+        return;
+    }
+    res.status = 204;
+}
+
 void ChessRoutes::handle_validate_move(const httplib::Request& req, httplib::Response& res) {
     add_cors_headers(res);
-    std::lock_guard<std::mutex> lock(mutex_);
 
     try {
         auto j = json::parse(req.body);
+        std::string gameId = gameIdFrom(req, j);
+        auto session = find_session(gameId, res);
+        if (!session) return;
+
+        std::lock_guard<std::mutex> lock(session->mutex);
+        ChessValidator& chessValidator = session->chessValidator;
 
         int fromX = j.at("fromX").get<int>();
         int fromY = j.at("fromY").get<int>();
@@ -121,8 +884,8 @@ void ChessRoutes::handle_validate_move(const httplib::Request& req, httplib::Res
         Coords from{ fromX, fromY };
         Coords to{ toX, toY };
 
-        auto legalMoves = chessValidator_.getLegalMoves(from);
-        bool isValid = chessValidator_.validateMove(from, to, promotionPiece);
+        auto legalMoves = chessValidator.getLegalMoves(from);
+        bool isValid = chessValidator.validateMove(from, to, promotionPiece);
 
         json response;
         response["valid"] = isValid;
@@ -137,24 +900,50 @@ void ChessRoutes::handle_validate_move(const httplib::Request& req, httplib::Res
         response["legalMoves"] = legalMovesJson;
 
         if (isValid) {
+            char boardFen[Fen::MaxLength];
+            std::size_t boardFenLength;
+
             // If valid and no promotion is pending, make the move
-            if (!chessValidator_.isPromotionPending() || !promotionPiece.empty()) {
-                chessValidator_.makeMove(from, to, promotionPiece);
+            if (!chessValidator.isPromotionPending() || !promotionPiece.empty()) {
+                // Only an unknown promotion piece gets this far and still fails; the board is unchanged
+                if (!chessValidator.makeMove(from, to, promotionPiece)) {
+                    res.status = 400;
+                    json error;
+                    error["error"] = "Bad request: invalid promotion piece '" + promotionPiece + "'";
+                    res.set_content(error.dump(), "application/json");
+                    return;
+                }
+
+                // The move makes any search still running for this game stale; a rejected one leaves them be
+                StockfishApiHandler::stopSearches(gameId);
 
-                // Update FEN for Stockfish
-                fen_ = chessValidator_.getBoardAsFen();
+                // Update FEN and move list for Stockfish
+                session->followBoard();
+                boardFenLength = session->fen.copy(boardFen, sizeof(boardFen));
+
+                // Publish before the engine search so board readers see the move right away
+                session->publishSnapshot();
+                write_tablebase_result(chessValidator.getPosition(), response);
+
+                // Playing the engine's move keeps its ponder on the predicted reply going; any other move ends it
+                StockfishApiHandler::followPondering(gameId, chessValidator.getHash());
+
+                // Hot-seat clients ask for a move after every ply, so pondering is opt-in here
                 if (j.value("getStockfishMove", false)) {
-                    std::string bestmove;
-                    if (StockfishApiHandler::getBestMoveFromStockfish(stockfishPath_, fen_, depth_, bestmove)) {
-                        bestmove_ = bestmove;
-                        response["stockfishMove"] = bestmove_;
+                    if (find_reply(*session, gameId, playingLimits(*session, j, false))) {
+                        response["stockfishMove"] = session->bestmove;
                     }
                 }
             }
+            else {
+                boardFenLength = chessValidator.writeFen(boardFen);
+                session->publishSnapshot();
+            }
 
-            response["promotionPending"] = chessValidator_.isPromotionPending();
-            response["boardFen"] = chessValidator_.getBoardAsFen();
-            response["turn"] = (chessValidator_.getCurrentTurn() == Color::White) ? "white" : "black";
+            response["promotionPending"] = chessValidator.isPromotionPending();
+            response["boardFen"] = std::string(boardFen, boardFenLength);
+            response["turn"] = (chessValidator.getCurrentTurn() == Color::White) ? "white" : "black";
+            write_game_status(chessValidator.getResult(), chessValidator.getTermination(), response);
         }
 
         res.set_content(response.dump(), "application/json");
@@ -167,21 +956,26 @@ void ChessRoutes::handle_validate_move(const httplib::Request& req, httplib::Res
     }
 }
 
-void ChessRoutes::handle_board_state(const httplib::Request&, httplib::Response& res) {
+void ChessRoutes::handle_board_state(const httplib::Request& req, httplib::Response& res) {
     add_cors_headers(res);
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto session = find_session(gameIdFrom(req), res);
+    if (!session) return;
+
+    // Served from the published snapshot, so this never waits on a move or an engine search
+    Epoch::Guard guard;
+    const BoardSnapshot* snapshot = session->snapshot();
 
     json response;
-    response["fen"] = chessValidator_.getBoardAsFen();
-    response["turn"] = (chessValidator_.getCurrentTurn() == Color::White) ? "white" : "black";
-    response["promotionPending"] = chessValidator_.isPromotionPending();
+    response["fen"] = snapshot->fen;
+    response["turn"] = (snapshot->turn == Color::White) ? "white" : "black";
+    response["promotionPending"] = snapshot->promotionPending;
+    write_game_status(snapshot->result, snapshot->termination, response);
 
     res.set_content(response.dump(), "application/json");
 }
 
 void ChessRoutes::handle_legal_moves(const httplib::Request& req, httplib::Response& res) {
     add_cors_headers(res);
-    std::lock_guard<std::mutex> lock(mutex_);
 
     try {
         int x = -1, y = -1;
@@ -193,20 +987,89 @@ void ChessRoutes::handle_legal_moves(const httplib::Request& req, httplib::Respo
             throw std::runtime_error("Missing x or y coordinates");
         }
 
-        auto legalMoves = chessValidator_.getLegalMoves({ x, y });
+        auto session = find_session(gameIdFrom(req), res);
+        if (!session) return;
+
+        Bitboard targets = 0;
+        if (x >= 0 && x < 8 && y >= 0 && y < 8) {
+            Epoch::Guard guard;
+            targets = session->snapshot()->legalTargets[Bitboards::squareFromCoords({ x, y })];
+        }
 
         json response;
         json movesArray = json::array();
 
-        for (const auto& move : legalMoves) {
+        int count = 0;
+        while (targets) {
+            Coords move = Bitboards::coordsFromSquare(Bitboards::popLsb(targets));
             movesArray.push_back({
                 {"x", move.x},
                 {"y", move.y}
                 });
+            count++;
         }
 
         response["moves"] = movesArray;
-        response["count"] = legalMoves.size();
+        response["count"] = count;
+
+        res.set_content(response.dump(), "application/json");
+    }
+    catch (const std::exception& e) {
+        res.status = 400;
+        json error;
+        error["error"] = std::string("Bad request: ") + e.what();
+        res.set_content(error.dump(), "application/json");
+    }
+}
+
+void ChessRoutes::handle_undo(const httplib::Request& req, httplib::Response& res) {
+    add_cors_headers(res);
+
+    try {
+        json body = req.body.empty() ? json() : json::parse(req.body);
+        std::string gameId = gameIdFrom(req, body);
+        auto session = find_session(gameId, res);
+        if (!session) return;
+
+        StockfishApiHandler::stopSearches(gameId);
+        StockfishApiHandler::stopPondering(gameId);
+
+        std::lock_guard<std::mutex> lock(session->mutex);
+        json response;
+        response["success"] = session->chessValidator.unmakeMove();
+        session->followBoard();
+        session->publishSnapshot();
+        write_history_state(*session, response);
+
+        res.set_content(response.dump(), "application/json");
+    }
+    catch (const std::exception& e) {
+        res.status = 400;
+        json error;
+        error["error"] = std::string("Bad request: ") + e.what();
+        res.set_content(error.dump(), "application/json");
+    }
+}
+
+void ChessRoutes::handle_goto_ply(const httplib::Request& req, httplib::Response& res) {
+    add_cors_headers(res);
+
+    try {
+        auto j = json::parse(req.body);
+        int ply = j.at("ply").get<int>();
+        std::string gameId = gameIdFrom(req, j);
+        auto session = find_session(gameId, res);
+        if (!session) return;
+
+        StockfishApiHandler::stopSearches(gameId);
+        StockfishApiHandler::stopPondering(gameId);
+
+        std::lock_guard<std::mutex> lock(session->mutex);
+        json response;
+        response["success"] = session->chessValidator.goToPly(ply);
+        session->followBoard();
+        session->publishSnapshot();
+        write_history_state(*session, response);
 
         res.set_content(response.dump(), "application/json");
     }
@@ -216,4 +1079,39 @@ void ChessRoutes::handle_legal_moves(const httplib::Request& req, httplib::Respo
         error["error"] = std::string("Bad request: ") + e.what();
         res.set_content(error.dump(), "application/json");
     }
+}
+
+void ChessRoutes::write_history_state(const GameSession& session, nlohmann::json& response) {
+    const ChessValidator& chessValidator = session.chessValidator;
+    response["fen"] = session.fen;
+    response["turn"] = (chessValidator.getCurrentTurn() == Color::White) ? "white" : "black";
+    response["promotionPending"] = chessValidator.isPromotionPending();
+    response["ply"] = chessValidator.getPly();
+    response["historyLength"] = chessValidator.getHistoryLength();
+    write_game_status(chessValidator.getResult(), chessValidator.getTermination(), response);
+}
+
+void ChessRoutes::write_tablebase_result(const Position& position, nlohmann::json& response) const {
+    SyzygyTablebases::Wdl wdl;
+    int dtz;
+    if (!tablebases_.probeWdl(position, wdl) || !tablebases_.probeDtz(position, dtz)) return;
+
+    // Counting the moves already played without a capture or pawn move, a win may no longer beat the fifty-move rule
+    wdl = SyzygyTablebases::fiftyMoveWdl(dtz, position.halfmoveClock());
+    GameResult result = GameResult::Draw;
+    if (wdl == SyzygyTablebases::Wdl::Win || wdl == SyzygyTablebases::Wdl::Loss) {
+        bool sideToMoveWins = wdl == SyzygyTablebases::Wdl::Win;
+        result = sideToMoveWins == (position.sideToMove() == Color::White) ? GameResult::WhiteWins : GameResult::BlackWins;
+    }
+
+    json tablebase;
+    tablebase["wdl"] = wdlToString(wdl);
+    tablebase["dtz"] = dtz;
+    tablebase["result"] = resultToString(result);
+    response["tablebase"] = tablebase;
+}
+
+void ChessRoutes::write_game_status(GameResult result, Termination termination, nlohmann::json& response) {
+    response["result"] = resultToString(result);
+    response["termination"] = terminationToString(termination);
 }
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "analysisCache.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+    const char Magic[8] = { 'R', 'C', 'A', 'N', 'A', 'L', 'Y', 'S' };
+    const std::uint32_t Version = 1;
+
+    /// Smallest table created, so a tiny size setting still caches something.
+    const std::uint64_t MinSlots = 1024;
+
+    enum SlotFlag : std::uint8_t {
+        HasScore = 1,
+        MateScore = 2,
+        BoundShift = 2
+    };
+}
+
+AnalysisCache::AnalysisCache()
+    : slotCount_(0),
+    hits_(0),
+    misses_(0) {
+}
+
+AnalysisCache::~AnalysisCache() {
+    close();
+}
+
+bool AnalysisCache::open(const Settings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.close();
+    slotCount_ = 0;
+
+    // A missing, truncated or foreign file is only a cache: start it over
+    if (!file_.openWritable(settings.path, true) || !validFile()) {
+        file_.close();
+        std::uint64_t slots = MinSlots;
+        std::uint64_t wanted = static_cast<std::uint64_t>(settings.sizeMb > 0 ? settings.sizeMb : 1) * 1024 * 1024 / sizeof(Slot);
+        while (slots * 2 <= wanted) {
+            slots *= 2;
+        }
+        if (!createFile(settings.path, slots) || !file_.openWritable(settings.path, true) || !validFile()) {
+            file_.close();
+            return false;
+        }
+    }
+
+    Header header;
+    std::memcpy(&header, file_.data(), sizeof(Header));
+    slotCount_ = static_cast<std::size_t>(header.slotCount);
+    return true;
+}
+
+void AnalysisCache::close() {
+    // Unmapping waits for the disk, so a clean shutdown loses nothing
+    file_.close();
+    slotCount_ = 0;
+}
+
+bool AnalysisCache::validFile() const {
+    if (file_.size() < sizeof(Header)) return false;
+    Header header;
+    std::memcpy(&header, file_.data(), sizeof(Header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0) return false;
+    if (header.version != Version || header.slotSize != sizeof(Slot)) return false;
+    if (header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0) return false;
+    return file_.size() == sizeof(Header) + header.slotCount * sizeof(Slot);
+}
+
+bool AnalysisCache::createFile(const std::string& path, std::uint64_t slotCount) {
+    // Built aside and renamed into place, so a crash never leaves a half-made file under the real name
+    std::string temporary = path + ".tmp";
+    {
+        Header header = {};
+        std::memcpy(header.magic, Magic, sizeof(Magic));
+        header.version = Version;
+        header.slotSize = sizeof(Slot);
+        header.slotCount = slotCount;
+
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.write(reinterpret_cast<const char*>(&header), sizeof(Header))) return false;
+    }
+
+    std::error_code error;
+    std::filesystem::resize_file(temporary, sizeof(Header) + slotCount * sizeof(Slot), error);
+    if (!error) {
+        std::filesystem::rename(temporary, path, error);
+    }
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t AnalysisCache::checksum(const Slot& slot) {
+    Slot copy = slot;
+    copy.check = 0;
+    std::uint64_t words[sizeof(Slot) / 8];
+    std::memcpy(words, &copy, sizeof(Slot));
+
+    std::uint64_t hash = 0x243F6A8885A308D3ULL;
+    for (std::uint64_t word : words) {
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 32;
+    }
+    // 0 is reserved for empty slots
+    return hash ? hash : 1;
+}
+
+bool AnalysisCache::lookup(std::uint64_t key, int depth, Entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.isOpen()) return false;
+
+    std::size_t home = static_cast<std::size_t>(key) & (slotCount_ - 1);
+    for (std::size_t i = 0; i < ProbeLength; i++) {
+        Slot slot;
+        std::memcpy(&slot, slots() + ((home + i) & (slotCount_ - 1)), sizeof(Slot));
+        if (slot.check == 0 || slot.key != key || checksum(slot) != slot.check) continue;
+
+        if (slot.depth < depth) break;
+
+        entry.depth = slot.depth;
+        entry.bestmove = Move::fromRaw(slot.bestmove);
+        entry.ponder = Move::fromRaw(slot.ponder);
+        entry.principal = Uci::Info();
+        entry.principal.depth = slot.depth;
+        entry.principal.hasScore = (slot.flags & HasScore) != 0;
+        entry.principal.mate = (slot.flags & MateScore) != 0;
+        entry.principal.score = slot.score;
+        entry.principal.bound = static_cast<Uci::Bound>((slot.flags >> BoundShift) & 3);
+        entry.principal.pvLength = std::min<int>(slot.pvLength, SlotPvLength);
+        for (int j = 0; j < entry.principal.pvLength; j++) {
+            entry.principal.pv[j] = Move::fromRaw(slot.pv[j]);
+        }
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void AnalysisCache::store(std::uint64_t key, const Entry& entry) {
+    Slot fresh = {};
+    fresh.key = key;
+    fresh.depth = static_cast<std::uint8_t>(std::min(entry.depth, 255));
+    fresh.score = entry.principal.score;
+    fresh.flags = static_cast<std::uint8_t>((entry.principal.hasScore ? HasScore : 0) | (entry.principal.mate ? MateScore : 0)
+        | (static_cast<int>(entry.principal.bound) << BoundShift));
+    fresh.bestmove = entry.bestmove.raw();
+    fresh.ponder = entry.ponder.raw();
+    fresh.pvLength = static_cast<std::uint8_t>(std::min(entry.principal.pvLength, SlotPvLength));
+    for (int i = 0; i < fresh.pvLength; i++) {
+        fresh.pv[i] = entry.principal.pv[i].raw();
+    }
+    fresh.check = checksum(fresh);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.isOpen()) return;
+
+    // The position's own slot if it has one, else the shallowest of the run; torn slots count as empty
+    std::size_t home = static_cast<std::size_t>(key) & (slotCount_ - 1);
+    Slot* victim = nullptr;
+    int victimDepth = 0;
+    for (std::size_t i = 0; i < ProbeLength; i++) {
+        Slot* target = slots() + ((home + i) & (slotCount_ - 1));
+        Slot slot;
+        std::memcpy(&slot, target, sizeof(Slot));
+        bool valid = slot.check != 0 && checksum(slot) == slot.check;
+
+        if (valid && slot.key == key) {
+            if (slot.depth <= fresh.depth) {
+                std::memcpy(target, &fresh, sizeof(Slot));
+            }
+            return;
+        }
+        int depth = valid ? slot.depth : -1;
+        if (!victim || depth < victimDepth) {
+            victim = target;
+            victimDepth = depth;
+        }
+    }
+    if (victimDepth > fresh.depth) return;
+
+    std::memcpy(victim, &fresh, sizeof(Slot));
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "mappedFile.h"
+#include "uci.h"
+
+/**
+ * @brief Engine results kept in a memory-mapped file, so they outlive the server process.
+ *
+ * The file is an open-addressing hash table of fixed 64-byte slots keyed by
+ * Zobrist hash. A key probes a short run of slots from its home slot. A result
+ * only replaces the stored one for its position if it is at least as deep, and
+ * a new position takes the shallowest slot of the run unless every slot there
+ * holds a deeper result. Each slot carries a checksum of its contents, so a
+ * slot torn by a crash mid-write reads as empty instead of as a wrong move.
+ * One server process per file.
+ */
+class AnalysisCache {
+public:
+    struct Settings {
+        std::string path;       ///< Cache file, created if missing; empty for no persistent cache.
+        int sizeMb = 64;        ///< Size of a new file; an existing valid file keeps its own size.
+    };
+
+    /**
+     * @brief A stored result: the best move and the engine's report on its line.
+     */
+    struct Entry {
+        int depth = 0;
+        Move bestmove;
+        Move ponder;            ///< None when the engine gave no expected reply.
+        Uci::Info principal;    ///< Score, bound and principal variation; pv is cut to the slot's capacity.
+    };
+
+    AnalysisCache();
+    ~AnalysisCache();
+
+    AnalysisCache(const AnalysisCache&) = delete;
+    AnalysisCache& operator=(const AnalysisCache&) = delete;
+
+    /**
+     * @brief Maps the cache file, creating or rebuilding it if it is missing or not a valid cache file.
+     * @return false if the file cannot be created or mapped.
+     */
+    bool open(const Settings& settings);
+    void close();
+
+    bool isOpen() const { return file_.isOpen(); }
+
+    /**
+     * @brief Looks up a result for the position searched to at least the given depth.
+     */
+    bool lookup(std::uint64_t key, int depth, Entry& entry);
+
+    /**
+     * @brief Stores a result unless the position already has a deeper one, or the probe run is full of deeper ones.
+     */
+    void store(std::uint64_t key, const Entry& entry);
+
+    std::uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    std::uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    std::size_t capacity() const { return slotCount_; }
+
+private:
+    /// PV moves that fit in a slot next to the rest of the entry.
+    static constexpr int SlotPvLength = 18;
+
+    /// Slots probed from a key's home slot; 512 bytes, so a probe touches at most two pages.
+    static constexpr std::size_t ProbeLength = 8;
+
+    struct Slot {
+        std::uint64_t key;
+        std::uint64_t check;        ///< Checksum of the rest of the slot; 0 marks an empty slot.
+        std::int32_t score;
+        std::uint8_t depth;
+        std::uint8_t flags;         ///< Bit 0: has a score, bit 1: mate score, bits 2-3: Uci::Bound.
+        std::uint8_t pvLength;
+        std::uint8_t reserved;
+        std::uint16_t bestmove;
+        std::uint16_t ponder;
+        std::uint16_t pv[SlotPvLength];
+    };
+    static_assert(sizeof(Slot) == 64, "cache slots must stay 64 bytes");
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t slotSize;
+        std::uint64_t slotCount;
+        std::uint8_t reserved[40];
+    };
+    static_assert(sizeof(Header) == 64, "the header must keep slots 64-byte aligned");
+
+    static std::uint64_t checksum(const Slot& slot);
+    static bool createFile(const std::string& path, std::uint64_t slotCount);
+    bool validFile() const;
+
+    Slot* slots() const { return reinterpret_cast<Slot*>(file_.writableData() + sizeof(Header)); }
+
+    std::mutex mutex_;
+    MappedFile file_;
+    std::size_t slotCount_;     ///< A power of two.
+    std::atomic<std::uint64_t> hits_;
+    std::atomic<std::uint64_t> misses_;
+};
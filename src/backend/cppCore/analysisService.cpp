@@ -0,0 +1,175 @@
+#include "analysisService.h"
+#include "stockfishHandler.h"
+#include "utility.h"
+
+namespace {
+    bool isFinished(AnalysisStatus status) {
+        return status == AnalysisStatus::Done || status == AnalysisStatus::Failed || status == AnalysisStatus::Cancelled;
+    }
+}
+
+AnalysisService::AnalysisService(const std::string& stockfishPath, int workerCount)
+    : stockfishPath_(stockfishPath),
+    stopping_(false) {
+    for (int i = 0; i < (workerCount > 0 ? workerCount : 1); i++) {
+        workers_.emplace_back(&AnalysisService::workerLoop, this);
+    }
+}
+
+AnalysisService::~AnalysisService() {
+    std::deque<std::shared_ptr<Job>> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+
+        // Stop running searches so the workers join at once instead of after their full limits
+        for (auto& entry : jobs_) {
+            if (entry.second->info.status == AnalysisStatus::Running) {
+                entry.second->control.stop();
+            }
+        }
+
+        abandoned.swap(queue_);
+        for (auto& job : abandoned) {
+            finish(*job, AnalysisStatus::Cancelled);
+        }
+    }
+    queueChanged_.notify_all();
+    jobChanged_.notify_all();
+
+    for (auto& job : abandoned) {
+        notifyFinished(*job);
+    }
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+std::string AnalysisService::submit(const std::string& fen, const SearchLimits& limits, const std::string& gameId,
+    FinishedCallback onFinished, InfoCallback onInfo) {
+    auto job = std::make_shared<Job>();
+    job->info.id = Utility::generate_id();
+    job->info.fen = fen;
+    job->info.gameId = gameId;
+    job->info.limits = limits;
+    job->onFinished = std::move(onFinished);
+    job->onInfo = std::move(onInfo);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pruneFinishedJobs();
+        jobs_.emplace(job->info.id, job);
+        queue_.push_back(job);
+    }
+    queueChanged_.notify_one();
+    return job->info.id;
+}
+
+bool AnalysisService::wait(const std::string& id, std::chrono::milliseconds timeout, AnalysisJobInfo& info) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Clients polling for results keep the table trimmed even when nothing new is submitted
+    pruneFinishedJobs();
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) return false;
+
+    // Hold our own reference in case the job is pruned while we sleep
+    std::shared_ptr<Job> job = it->second;
+    jobChanged_.wait_for(lock, timeout, [&]() { return stopping_ || isFinished(job->info.status); });
+
+    info = job->info;
+    return true;
+}
+
+bool AnalysisService::cancel(const std::string& id) {
+    std::shared_ptr<Job> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pruneFinishedJobs();
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) return false;
+
+        cancelled = it->second;
+        Job& job = *cancelled;
+        if (isFinished(job.info.status)) return true;
+
+        if (job.info.status == AnalysisStatus::Running) {
+            job.control.stop();
+        }
+        else {
+            for (auto queued = queue_.begin(); queued != queue_.end(); ++queued) {
+                if (queued->get() == &job) {
+                    queue_.erase(queued);
+                    break;
+                }
+            }
+        }
+        finish(job, AnalysisStatus::Cancelled);
+    }
+    jobChanged_.notify_all();
+    notifyFinished(*cancelled);
+    return true;
+}
+
+void AnalysisService::workerLoop() {
+    for (;;) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queueChanged_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+
+            job = queue_.front();
+            queue_.pop_front();
+            job->info.status = AnalysisStatus::Running;
+        }
+        jobChanged_.notify_all();
+
+        // The search runs without the service lock so other jobs can be queued, polled and cancelled meanwhile
+        SearchResult result;
+        bool ok = StockfishApiHandler::search(stockfishPath_, job->info.fen, job->info.limits, job->info.gameId, result, job->onInfo, &job->control);
+
+        bool finished = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // A job cancelled mid-search was already finished by cancel()
+            if (job->info.status == AnalysisStatus::Running) {
+                job->info.bestmove = result.bestmove;
+                job->info.ponder = result.ponder;
+                job->info.principal = result.principal;
+                job->info.stopped = result.stopped;
+                job->info.cached = result.cached;
+                finish(*job, ok ? AnalysisStatus::Done : AnalysisStatus::Failed);
+                finished = true;
+            }
+        }
+        jobChanged_.notify_all();
+        if (finished) {
+            notifyFinished(*job);
+        }
+    }
+}
+
+void AnalysisService::finish(Job& job, AnalysisStatus status) {
+    job.info.status = status;
+    job.finishedAt = std::chrono::steady_clock::now();
+}
+
+void AnalysisService::notifyFinished(Job& job) {
+    // Only the thread that finished the job gets here, and the info no longer changes
+    if (job.onFinished) {
+        job.onFinished(job.info);
+        job.onFinished = nullptr;
+    }
+}
+
+void AnalysisService::pruneFinishedJobs() {
+    auto cutoff = std::chrono::steady_clock::now() - ResultRetention;
+    for (auto it = jobs_.begin(); it != jobs_.end();) {
+        if (isFinished(it->second->info.status) && it->second->finishedAt < cutoff) {
+            it = jobs_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "stockfishHandler.h"
+
+enum class AnalysisStatus {
+    Queued, Running, Done, Failed, Cancelled
+};
+
+/**
+ * @brief Copy of an analysis job's state at one point in time.
+ */
+struct AnalysisJobInfo {
+    std::string id;
+    std::string fen;
+    std::string gameId;     ///< Game the position came from, if any; used for engine affinity.
+    SearchLimits limits;
+    AnalysisStatus status = AnalysisStatus::Queued;
+    std::string bestmove;   ///< Set once status is Done.
+    std::string ponder;
+    Uci::Info principal;    ///< The engine's final report on its best line, if it searched.
+    bool stopped = false;   ///< The search hit its deadline or was superseded before completing.
+    bool cached = false;    ///< Answered from the bestmove cache without a search.
+};
+
+/**
+ * @brief Runs engine searches on dedicated worker threads.
+ *
+ * Callers submit a job and get its id back immediately, then poll or wait for
+ * the result. HTTP threads therefore never block on the engine except for the
+ * bounded long-poll a client asks for. Size the workers to the engine pool.
+ */
+class AnalysisService {
+public:
+    AnalysisService(const std::string& stockfishPath, int workerCount = 1);
+    /**
+     * @brief Stops running searches and cancels queued jobs, then joins the workers.
+     */
+    ~AnalysisService();
+
+    AnalysisService(const AnalysisService&) = delete;
+    AnalysisService& operator=(const AnalysisService&) = delete;
+
+    /**
+     * @brief Called once when a job is done, failed or cancelled, on the thread that finished it and without the service lock.
+     */
+    using FinishedCallback = std::function<void(const AnalysisJobInfo&)>;
+
+    /**
+     * @brief Called with every info line while the job's search runs, on the worker thread.
+     */
+    using InfoCallback = std::function<void(const Uci::Info&)>;
+
+    /**
+     * @brief Queues a search and returns the job id.
+     */
+    std::string submit(const std::string& fen, const SearchLimits& limits, const std::string& gameId = std::string(),
+        FinishedCallback onFinished = nullptr, InfoCallback onInfo = nullptr);
+
+    /**
+     * @brief Waits up to timeout for the job to finish, then reports its state.
+     * @return false if there is no job with that id.
+     */
+    bool wait(const std::string& id, std::chrono::milliseconds timeout, AnalysisJobInfo& info);
+
+    /**
+     * @brief Cancels a queued or running job. A running search is stopped and its result discarded.
+     * @return false if there is no job with that id.
+     */
+    bool cancel(const std::string& id);
+
+    /// Number of searches that can run at once.
+    int workerCount() const { return static_cast<int>(workers_.size()); }
+
+private:
+    struct Job {
+        AnalysisJobInfo info;
+        SearchControl control;
+        FinishedCallback onFinished;
+        InfoCallback onInfo;
+        std::chrono::steady_clock::time_point finishedAt;
+    };
+
+    /// Finished jobs are kept this long so clients can still collect them; older ones are dropped on the next submit, wait or cancel.
+    static constexpr std::chrono::minutes ResultRetention{ 5 };
+
+    void workerLoop();
+    void finish(Job& job, AnalysisStatus status);
+    void notifyFinished(Job& job);
+    void pruneFinishedJobs();
+
+    std::string stockfishPath_;
+    std::mutex mutex_;
+    std::condition_variable queueChanged_;
+    std::condition_variable jobChanged_;
+    std::deque<std::shared_ptr<Job>> queue_;
+    std::unordered_map<std::string, std::shared_ptr<Job>> jobs_;
+    std::vector<std::thread> workers_;
+    bool stopping_;
+};
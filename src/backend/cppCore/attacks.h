@@ -0,0 +1,137 @@
+#pragma once
+
+#include "bitboard.h"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <immintrin.h>
+#define CPPCORE_HAS_PEXT 1
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define CPPCORE_HAS_PEXT 1
+#endif
+
+/**
+ * @brief Precomputed attack tables.
+ *
+ * Leaper attacks (pawn, knight, king) are plain per-square lookups built at
+ * compile time. Slider
+ * attacks use one table per square indexed either by a magic multiply or, on
+ * CPUs with BMI2, by PEXT. The indexing scheme is chosen once at startup and
+ * the tables are filled to match it.
+ */
+namespace Attacks {
+
+    struct SliderTable {
+        Bitboard mask;
+        Bitboard magic;
+        const Bitboard* attacks;
+        unsigned shift;
+    };
+
+    struct LeaperTables {
+        Bitboard pawn[2][64];
+        Bitboard knight[64];
+        Bitboard king[64];
+
+        constexpr LeaperTables() : pawn(), knight(), king() {
+            for (int square = 0; square < 64; square++) {
+                pawn[0][square] = step(square, -1, 1) | step(square, 1, 1);
+                pawn[1][square] = step(square, -1, -1) | step(square, 1, -1);
+
+                knight[square] = step(square, 1, 2) | step(square, 2, 1) | step(square, 2, -1) | step(square, 1, -2) |
+                    step(square, -1, -2) | step(square, -2, -1) | step(square, -2, 1) | step(square, -1, 2);
+
+                king[square] = step(square, -1, -1) | step(square, -1, 0) | step(square, -1, 1) | step(square, 0, -1) |
+                    step(square, 0, 1) | step(square, 1, -1) | step(square, 1, 0) | step(square, 1, 1);
+            }
+        }
+
+    private:
+        static constexpr Bitboard step(int square, int df, int dr) {
+            return (Bitboards::fileOf(square) + df < 0 || Bitboards::fileOf(square) + df > 7 ||
+                Bitboards::rankOf(square) + dr < 0 || Bitboards::rankOf(square) + dr > 7)
+                ? 0
+                : Bitboards::squareBit(Bitboards::makeSquare(Bitboards::fileOf(square) + df, Bitboards::rankOf(square) + dr));
+        }
+    };
+
+    extern const LeaperTables leapers;
+    extern SliderTable rookTables[64];
+    extern SliderTable bishopTables[64];
+    extern Bitboard betweenTable[64][64];
+    extern Bitboard lineTable[64][64];
+    extern bool usePext;
+
+#ifdef CPPCORE_HAS_PEXT
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((target("bmi2")))
+#endif
+    inline Bitboard pext(Bitboard value, Bitboard mask) {
+        return _pext_u64(value, mask);
+    }
+#endif
+
+    inline unsigned sliderIndex(const SliderTable& table, Bitboard occupied) {
+#ifdef CPPCORE_HAS_PEXT
+        if (usePext) {
+            return static_cast<unsigned>(pext(occupied, table.mask));
+        }
+#endif
+        return static_cast<unsigned>(((occupied & table.mask) * table.magic) >> table.shift);
+    }
+
+    inline Bitboard pawnAttacks(Color color, int square) {
+        return leapers.pawn[static_cast<int>(color)][square];
+    }
+
+    inline Bitboard knightAttacks(int square) { return leapers.knight[square]; }
+    inline Bitboard kingAttacks(int square) { return leapers.king[square]; }
+
+    inline Bitboard rookAttacks(int square, Bitboard occupied) {
+        const SliderTable& table = rookTables[square];
+        return table.attacks[sliderIndex(table, occupied)];
+    }
+
+    inline Bitboard bishopAttacks(int square, Bitboard occupied) {
+        const SliderTable& table = bishopTables[square];
+        return table.attacks[sliderIndex(table, occupied)];
+    }
+
+    inline Bitboard queenAttacks(int square, Bitboard occupied) {
+        return rookAttacks(square, occupied) | bishopAttacks(square, occupied);
+    }
+
+    /**
+     * @brief Attacks of a non-pawn piece type chosen at compile time.
+     */
+    template<PieceType Pt>
+    Bitboard attacksFrom(int square, Bitboard occupied);
+
+    template<>
+    inline Bitboard attacksFrom<PieceType::Knight>(int square, Bitboard) { return knightAttacks(square); }
+
+    template<>
+    inline Bitboard attacksFrom<PieceType::Bishop>(int square, Bitboard occupied) { return bishopAttacks(square, occupied); }
+
+    template<>
+    inline Bitboard attacksFrom<PieceType::Rook>(int square, Bitboard occupied) { return rookAttacks(square, occupied); }
+
+    template<>
+    inline Bitboard attacksFrom<PieceType::Queen>(int square, Bitboard occupied) { return queenAttacks(square, occupied); }
+
+    template<>
+    inline Bitboard attacksFrom<PieceType::King>(int square, Bitboard) { return kingAttacks(square); }
+
+    /**
+     * @brief Squares strictly between two squares on a shared rank, file or diagonal, plus the second square.
+     *
+     * Empty (apart from b) if the squares are not aligned. Including b lets the
+     * result double as the set of squares that block or capture a slider check.
+     */
+    inline Bitboard between(int a, int b) { return betweenTable[a][b]; }
+
+    /**
+     * @brief The full rank, file or diagonal through both squares, or 0 if they are not aligned.
+     */
+    inline Bitboard line(int a, int b) { return lineTable[a][b]; }
+}
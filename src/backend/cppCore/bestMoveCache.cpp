@@ -0,0 +1,73 @@
+#include "bestMoveCache.h"
+
+BestMoveCache::BestMoveCache(std::size_t capacity)
+    : entries_(capacity > 0 ? capacity : 1),
+    hand_(0),
+    hits_(0),
+    misses_(0) {
+    slots_.reserve(entries_.size());
+}
+
+bool BestMoveCache::lookup(std::uint64_t key, int depth, std::string& bestmove) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = slots_.find(key);
+    if (it == slots_.end() || entries_[it->second].depth < depth) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Entry& entry = entries_[it->second];
+    entry.referenced = true;
+    bestmove = entry.bestmove;
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void BestMoveCache::store(std::uint64_t key, int depth, const std::string& bestmove) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = slots_.find(key);
+    if (it != slots_.end()) {
+        Entry& entry = entries_[it->second];
+        if (depth >= entry.depth) {
+            entry.depth = depth;
+            entry.bestmove = bestmove;
+        }
+        entry.referenced = true;
+        return;
+    }
+
+    std::size_t slot = evict();
+    Entry& entry = entries_[slot];
+    entry.key = key;
+    entry.depth = depth;
+    entry.bestmove = bestmove;
+    entry.used = true;
+    entry.referenced = false;
+    slots_[key] = slot;
+}
+
+std::size_t BestMoveCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size();
+}
+
+std::size_t BestMoveCache::evict() {
+    // Sweep the hand forward, giving every referenced entry a second chance
+    for (;;) {
+        Entry& entry = entries_[hand_];
+        std::size_t slot = hand_;
+        hand_ = (hand_ + 1) % entries_.size();
+
+        if (!entry.used) return slot;
+        if (entry.referenced) {
+            entry.referenced = false;
+            continue;
+        }
+
+        slots_.erase(entry.key);
+        entry.used = false;
+        return slot;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Bounded cache of engine results keyed by position hash.
+ *
+ * A result searched to some depth also answers requests for any shallower
+ * depth, and a deeper result replaces a shallower one. When the cache is full
+ * the CLOCK algorithm evicts an entry that has not been hit since the hand last
+ * passed it, which approximates LRU without reordering on every hit.
+ */
+class BestMoveCache {
+public:
+    explicit BestMoveCache(std::size_t capacity);
+
+    /**
+     * @brief Looks up a result for the position searched to at least the given depth.
+     */
+    bool lookup(std::uint64_t key, int depth, std::string& bestmove);
+    void store(std::uint64_t key, int depth, const std::string& bestmove);
+
+    std::uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    std::uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    std::size_t size() const;
+    std::size_t capacity() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        std::uint64_t key = 0;
+        int depth = 0;
+        std::string bestmove;
+        bool used = false;
+        bool referenced = false;
+    };
+
+    std::size_t evict();
+
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+    std::unordered_map<std::uint64_t, std::size_t> slots_;
+    std::size_t hand_;
+    std::atomic<std::uint64_t> hits_;
+    std::atomic<std::uint64_t> misses_;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include "chessTypes.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief A set of squares, one bit per square.
+ *
+ * Squares are numbered little-endian rank-file: a1 = 0, h1 = 7, a8 = 56, h8 = 63.
+ */
+using Bitboard = std::uint64_t;
+
+namespace Bitboards {
+
+    constexpr int NoSquare = -1;
+
+    constexpr Bitboard FileA = 0x0101010101010101ULL;
+    constexpr Bitboard FileH = FileA << 7;
+    constexpr Bitboard Rank1 = 0xFFULL;
+    constexpr Bitboard Rank8 = Rank1 << 56;
+
+    enum Direction : int {
+        North = 8,
+        South = -8,
+        NorthEast = 9,
+        NorthWest = 7,
+        SouthEast = -7,
+        SouthWest = -9
+    };
+
+    constexpr Bitboard squareBit(int square) { return Bitboard(1) << square; }
+
+    /**
+     * @brief Moves every square of the set one step in direction D, dropping squares that would wrap around the board edge.
+     */
+    template<Direction D>
+    constexpr Bitboard shift(Bitboard b) {
+        return D == North ? b << 8
+            : D == South ? b >> 8
+            : D == NorthEast ? (b & ~FileH) << 9
+            : D == NorthWest ? (b & ~FileA) << 7
+            : D == SouthEast ? (b & ~FileH) >> 7
+            : (b & ~FileA) >> 9;
+    }
+    constexpr int makeSquare(int file, int rank) { return rank * 8 + file; }
+    constexpr int fileOf(int square) { return square & 7; }
+    constexpr int rankOf(int square) { return square >> 3; }
+
+    inline int squareFromCoords(const Coords& coords) {
+        return makeSquare(coords.y, 7 - coords.x);
+    }
+
+    inline Coords coordsFromSquare(int square) {
+        return { 7 - rankOf(square), fileOf(square) };
+    }
+
+    inline int popCount(Bitboard b) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return static_cast<int>(__popcnt64(b));
+#elif defined(_MSC_VER)
+        return static_cast<int>(__popcnt(static_cast<unsigned>(b)) + __popcnt(static_cast<unsigned>(b >> 32)));
+#else
+        return __builtin_popcountll(b);
+#endif
+    }
+
+    /**
+     * @brief Index of the least significant set bit. b must be non-zero.
+     */
+    inline int lsb(Bitboard b) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, b);
+        return static_cast<int>(index);
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (static_cast<unsigned>(b)) {
+            _BitScanForward(&index, static_cast<unsigned>(b));
+            return static_cast<int>(index);
+        }
+        _BitScanForward(&index, static_cast<unsigned>(b >> 32));
+        return static_cast<int>(index) + 32;
+#else
+        return __builtin_ctzll(b);
+#endif
+    }
+
+    inline int popLsb(Bitboard& b) {
+        int square = lsb(b);
+        b &= b - 1;
+        return square;
+    }
+
+    inline bool moreThanOne(Bitboard b) {
+        return (b & (b - 1)) != 0;
+    }
+}
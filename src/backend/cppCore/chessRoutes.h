@@ -1,28 +1,132 @@
 #pragma once
 
+#include <memory>
 #include <string>
-#include <mutex>
 #include "external/httplib.h"
-#include "ChessValidator.h"
+#include "external/json.hpp"
+#include "chessValidator.h"
+#include "gameSessionStore.h"
+#include "analysisService.h"
+#include "openingBook.h"
+#include "syzygyTablebases.h"
 
+/**
+ * @brief HTTP routes for playing games against the validator and Stockfish.
+ *
+ * Every route takes an optional "gameId" (JSON body field or query parameter)
+ * naming a session created by POST /games; without one the shared default
+ * game is used. Requests for different games run in parallel, and the
+ * read-only /board and /legal-moves routes never take a game's lock.
+ */
 class ChessRoutes {
 public:
-    ChessRoutes(const std::string& stockfishPath);
+    /**
+     * @param book Opening book answered from before Stockfish is asked; none if its path is empty.
+     * @param tablebases Endgame tables that answer small enough positions without Stockfish; none if the path is empty.
+     * @param analysisCache File keeping engine results across restarts; none if the path is empty.
+     */
+    ChessRoutes(const std::string& stockfishPath, int engineCount = 1, const OpeningBook::Settings& book = OpeningBook::Settings(),
+        const SyzygyTablebases::Settings& tablebases = SyzygyTablebases::Settings(),
+        const AnalysisCache::Settings& analysisCache = AnalysisCache::Settings());
 
     void registerRoutes(httplib::Server& svr);
+
+    /**
+     * @brief POST /games: starts a new game, optionally from {"fen": ..., "depth": n}, and returns its gameId.
+     *
+     * Every route that searches also accepts "movetime", "nodes", "wtime", "btime", "winc", "binc" and a hard
+     * "deadline" in milliseconds; at the deadline the engine is stopped and its best move so far is returned.
+     * Moving, undoing or setting a new position stops any search still running for the game.
+     * After answering with its move, the engine ponders on the reply it predicts: on POST / unless the request
+     * sets "ponder": false, and on POST /validate-move with getStockfishMove only if it sets "ponder": true.
+     * The ponder goes on while the game plays the engine's move, and if the predicted reply follows, the next search
+     * for it is answered at once, whether or not that request asks to ponder.
+     */
+    void handle_create_game(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief DELETE /games/{id}: ends a game and frees its session.
+     */
+    void handle_delete_game(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief POST /validate-move: plays a move, optionally answering with Stockfish's reply. When the resulting
+     * position is in the endgame tablebases, "tablebase" gives its exact value for the side to move, with the
+     * fifty-move rule applied from the position's halfmove clock.
+     */
     void handle_validate_move(const httplib::Request& req, httplib::Response& res);
     void handle_board_state(const httplib::Request& req, httplib::Response& res);
     void handle_legal_moves(const httplib::Request& req, httplib::Response& res);
     void handle_stockfish_post(const httplib::Request& req, httplib::Response& res);
     void handle_stockfish_get(const httplib::Request& req, httplib::Response& res);
 
+    /**
+     * @brief GET /cache-stats: hit and miss counters of the bestmove cache, and of the persistent cache under "persistent" if one is open.
+     */
+    void handle_cache_stats(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief POST /analysis: queues a search of {"fen"} (or the game's position) to {"depth"} (or other limits) and returns a jobId.
+     */
+    void handle_analysis_submit(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief GET /analysis/{id}?timeout=ms: job state, waiting up to timeout for the search to finish.
+     */
+    void handle_analysis_get(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief GET /analysis/stream?fen=&depth=&deadline=: Server-Sent Events with each engine info line as the search deepens,
+     * then the bestmove. Runs as an analysis job, so streams share the bounded workers; the job is cancelled if the client disconnects.
+     */
+    void handle_analysis_stream(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief POST /analysis/batch: analyses {"fens": [...]}, or every position of {"moves": [...]} played from {"fen"}
+     * or the initial position, spread over all engines. Streams Server-Sent Events: "start", one "result" per
+     * position in completion order (with its "index"), then a "summary" with throughput. Leaving cancels the rest.
+     */
+    void handle_analysis_batch(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief DELETE /analysis/{id}: cancels a job.
+     */
+    void handle_analysis_cancel(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief POST /undo: takes back the last move.
+     */
+    void handle_undo(const httplib::Request& req, httplib::Response& res);
+
+    /**
+     * @brief POST /goto-ply: jumps to {"ply": n} in the game history, keeping later moves for redo.
+     */
+    void handle_goto_ply(const httplib::Request& req, httplib::Response& res);
+
 private:
     std::string stockfishPath_;
-    std::string fen_;
-    int depth_;
-    std::string bestmove_;
-    std::mutex mutex_;
-    ChessValidator chessValidator_;
+    GameSessionStore sessions_;
+    AnalysisService analysis_;
+    OpeningBook book_;
+    SyzygyTablebases tablebases_;
 
     static void add_cors_headers(httplib::Response& res);
+
+    /**
+     * @brief Looks up a session, answering 404 on res if it does not exist.
+     */
+    std::shared_ptr<GameSession> find_session(const std::string& gameId, httplib::Response& res);
+
+    /**
+     * @brief Picks the move to play in the session's position into session.bestmove: the tablebase-optimal move
+     * in a covered endgame, else a book move if the book has one, otherwise Stockfish's. Call with the session's mutex held.
+     * @return false if Stockfish failed.
+     */
+    bool find_reply(GameSession& session, const std::string& gameId, const SearchLimits& limits);
+    /**
+     * @brief Adds "tablebase" with the position's value and distance to zeroing if the tables cover it.
+     */
+    void write_tablebase_result(const Position& position, nlohmann::json& response) const;
+    static void write_history_state(const GameSession& session, nlohmann::json& response);
+    static void write_game_status(GameResult result, Termination termination, nlohmann::json& response);
 };
\ No newline at end of file
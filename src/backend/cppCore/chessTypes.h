@@ -0,0 +1,36 @@
+#pragma once
+
+enum class PieceType {
+    Pawn, Knight, Bishop, Rook, Queen, King, None
+};
+
+enum class Color {
+    White, Black, None
+};
+
+enum class GameResult {
+    Ongoing, WhiteWins, BlackWins, Draw
+};
+
+enum class Termination {
+    None, Checkmate, Stalemate, FiftyMoveRule, ThreefoldRepetition, InsufficientMaterial
+};
+
+/**
+ * @brief Board coordinates as used by the HTTP API.
+ *
+ * x is the row counted from Black's back rank (0 = rank 8),
+ * y is the column counted from the a-file (0 = file a).
+ */
+struct Coords {
+    int x;
+    int y;
+
+    bool operator==(const Coords& other) const {
+        return x == other.x && y == other.y;
+    }
+};
+
+constexpr Color opposite(Color color) {
+    return color == Color::White ? Color::Black : Color::White;
+}
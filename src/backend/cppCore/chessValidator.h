@@ -2,40 +2,11 @@
 
 #include <vector>
 #include <string>
-#include <memory>
-
-enum class PieceType {
-    Pawn, Knight, Bishop, Rook, Queen, King, None
-};
-
-enum class Color {
-    White, Black, None
-};
-
-struct Coords {
-    int x;
-    int y;
-
-    bool operator==(const Coords& other) const {
-        return x == other.x && y == other.y;
-    }
-};
-
-class Piece {
-public:
-    Piece(PieceType type, Color color);
-    virtual ~Piece() = default;
-
-    PieceType getType() const { return type_; }
-    Color getColor() const { return color_; }
-    bool getHasMoved() const { return hasMoved_; }
-    void setHasMoved() { hasMoved_ = true; }
-
-private:
-    PieceType type_;
-    Color color_;
-    bool hasMoved_ = false;
-};
+#include <string_view>
+#include "chessTypes.h"
+#include "position.h"
+#include "move.h"
+#include "fen.h"
 
 class ChessValidator {
 public:
@@ -43,41 +14,113 @@ public:
     ~ChessValidator();
 
     void initializeBoard();
-    bool setBoardFromFen(const std::string& fen);
+    /**
+     * @brief Loads a position and clears the game history.
+     * @param error If given, receives the reason a rejected FEN was invalid.
+     */
+    bool setBoardFromFen(std::string_view fen, Fen::Error* error = nullptr);
     std::string getBoardAsFen() const;
 
+    /**
+     * @brief Writes the current FEN into buffer, which must hold at least Fen::MaxLength bytes.
+     * @return The length written.
+     */
+    std::size_t writeFen(char* buffer) const;
+
+    /**
+     * @brief Writes the arguments of a UCI "position" command that reaches the current position through the game's moves,
+     * e.g. "startpos moves e2e4 e7e5", or "fen <loaded position> moves ..." when the game started from a FEN.
+     */
+    void writeUciPosition(std::string& out) const;
+    int getFullmoveNumber() const;
+
     bool validateMove(const Coords& from, const Coords& to, const std::string& promotionPiece = "");
     bool makeMove(const Coords& from, const Coords& to, const std::string& promotionPiece = "");
 
-    Color getCurrentTurn() const { return currentTurn_; }
+    Color getCurrentTurn() const { return position_.sideToMove(); }
     bool isPromotionPending() const { return promotionPending_; }
+    const Position& getPosition() const { return position_; }
+    std::uint64_t getHash() const { return position_.key(); }
 
-    std::vector<Coords> getLegalMoves(const Coords& position);
+    std::vector<Coords> getLegalMoves(const Coords& position) const;
+
+    /**
+     * @brief Fills the list with every legal move of the side to move.
+     *
+     * Does not allocate; the list is meant to live on the caller's stack.
+     */
+    void generateAllLegalMoves(MoveList& moves) const;
+
+    /**
+     * @brief For every square, the legal targets of the piece standing on it (either color), as getLegalMoves reports them.
+     */
+    void getAllLegalTargets(Bitboard (&targets)[64]) const;
+
+    /**
+     * @brief Plays a move taken from generateAllLegalMoves without validating it again.
+     *
+     * Playing a move after stepping back in history discards the moves that followed.
+     */
+    void applyMove(Move move);
+
+    /**
+     * @brief Takes back the last played move in constant time.
+     *
+     * The move stays in history and can be replayed with goToPly.
+     * @return false when already at the start of the game.
+     */
+    bool unmakeMove();
+
+    /**
+     * @brief Moves to the given ply of the game history (0 is the starting position).
+     *
+     * Short distances are walked move by move; longer jumps restore the nearest
+     * checkpoint at or before the target and replay from there.
+     * @return false when ply is outside [0, getHistoryLength()].
+     */
+    bool goToPly(int ply);
+
+    /**
+     * @brief Outcome of the current position, refreshed after every move, takeback and position load.
+     *
+     * The fifty-move rule and threefold repetition end the game as soon as they apply.
+     */
+    GameResult getResult() const { return result_; }
+    Termination getTermination() const { return termination_; }
+
+    /**
+     * @brief How many earlier positions since the last irreversible move equal the current one.
+     */
+    int countRepetitions() const;
+
+    int getPly() const { return ply_; }
+    int getHistoryLength() const { return static_cast<int>(history_.size()); }
 
 private:
-    std::vector<std::vector<std::shared_ptr<Piece>>> board_;
-    Color currentTurn_;
-    std::pair<Coords, Coords> lastMove_;
+    /// A full position is kept every CheckpointInterval plies to bound replay on long jumps.
+    static constexpr int CheckpointInterval = 16;
+
+    struct HistoryEntry {
+        Move move;
+        UndoInfo undo;
+    };
+
+    Position position_;
     bool promotionPending_ = false;
     Coords pendingPromotionFrom_;
     Coords pendingPromotionTo_;
+    std::vector<HistoryEntry> history_;
+    std::vector<Position> checkpoints_;
+    int ply_ = 0;
+    int rootFullmoveNumber_ = 1;
+    GameResult result_ = GameResult::Ongoing;
+    Termination termination_ = Termination::None;
 
     bool isValidPosition(const Coords& coords) const;
-    bool isPieceAtPosition(const Coords& coords) const;
-    bool isSquareAttacked(const Coords& position, Color defendingColor);
-    bool isKingInCheck(Color kingColor);
-    Coords findKing(Color kingColor);
-    std::vector<Coords> getPieceMoves(const Coords& from, bool checkForCheck);
-    std::vector<Coords> getPawnMoves(const Coords& from, bool checkForCheck);
-    std::vector<Coords> getKnightMoves(const Coords& from, bool checkForCheck);
-    std::vector<Coords> getBishopMoves(const Coords& from, bool checkForCheck);
-    std::vector<Coords> getRookMoves(const Coords& from, bool checkForCheck);
-    std::vector<Coords> getQueenMoves(const Coords& from, bool checkForCheck);
-    std::vector<Coords> getKingMoves(const Coords& from, bool checkForCheck);
-    std::vector<Coords> getCastlingMoves(const Coords& from);
-    bool canCastle(const Coords& from, const Coords& to);
-    bool isEnPassant(const Coords& from, const Coords& to);
-    bool isPromotion(const Coords& from, const Coords& to);
-    std::shared_ptr<Piece> createPiece(PieceType type, Color color);
-    bool wouldMoveLeaveKingInCheck(const Coords& from, const Coords& to);
+    Bitboard getLegalTargets(int from) const;
+    Move findLegalMove(int from, int to, PieceType promotion) const;
+    bool isPromotion(int from, int to) const;
+    void resetHistory();
+    void redoMove();
+    void updateGameStatus();
 };
\ No newline at end of file
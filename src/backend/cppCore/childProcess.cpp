@@ -0,0 +1,290 @@
+#include "childProcess.h"
+
+#ifndef _WIN32
+#include "pipeMultiplexer.h"
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+ChildProcess::~ChildProcess() {
+    stop();
+}
+
+bool ChildProcess::readLine(std::string& line, std::chrono::milliseconds timeout) {
+    return readLines([&](std::string_view next) {
+        line.assign(next.data(), next.size());
+        return true;
+        }, timeout);
+}
+
+bool ChildProcess::readUntil(const std::string& marker, std::string& output, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(bufferMutex_);
+
+    // Resume each search where the last one left off, allowing for a marker split across chunks
+    std::size_t searched = 0;
+    std::size_t found = std::string_view::npos;
+    bool ready = waitForOutput(lock, timeout, [&]() {
+        std::string_view contents = output_.contents();
+        found = contents.find(marker, searched);
+        if (found != std::string_view::npos) return true;
+        searched = contents.size() >= marker.size() ? contents.size() - marker.size() + 1 : 0;
+        return false;
+        });
+    if (!ready) return false;
+
+    output.assign(output_.contents().substr(0, found + marker.size()));
+    output_.consume(found + marker.size());
+    return true;
+}
+
+std::string ChildProcess::drain() {
+    std::lock_guard<std::mutex> lock(bufferMutex_);
+    std::string output(output_.contents());
+    output_.clear();
+    return output;
+}
+
+void ChildProcess::onOutput(const char* data, std::size_t length) {
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex_);
+        output_.append(data, length);
+    }
+    outputChanged_.notify_all();
+}
+
+void ChildProcess::onClosed() {
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex_);
+        closed_ = true;
+    }
+    outputChanged_.notify_all();
+}
+
+#ifdef _WIN32
+
+ChildProcess::ChildProcess()
+    : closed_(true), hProcess_(NULL), hThread_(NULL), hChildStdinWr_(NULL), hChildStdoutRd_(NULL) {
+}
+
+bool ChildProcess::start(const std::string& path, const std::vector<std::string>& args) {
+    SECURITY_ATTRIBUTES saAttr{};
+    saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
+    saAttr.bInheritHandle = TRUE;
+    saAttr.lpSecurityDescriptor = NULL;
+
+    HANDLE hChildStdinRd = NULL;
+    HANDLE hChildStdoutWr = NULL;
+
+    // Create pipes for STDIN and STDOUT
+    if (!CreatePipe(&hChildStdoutRd_, &hChildStdoutWr, &saAttr, 0)) return false;
+    if (!SetHandleInformation(hChildStdoutRd_, HANDLE_FLAG_INHERIT, 0)) return false;
+    if (!CreatePipe(&hChildStdinRd, &hChildStdinWr_, &saAttr, 0)) return false;
+    if (!SetHandleInformation(hChildStdinWr_, HANDLE_FLAG_INHERIT, 0)) return false;
+
+    PROCESS_INFORMATION pi{};
+    STARTUPINFOA si{};
+    si.cb = sizeof(STARTUPINFOA);
+    si.hStdError = hChildStdoutWr;
+    si.hStdOutput = hChildStdoutWr;
+    si.hStdInput = hChildStdinRd;
+    si.dwFlags |= STARTF_USESTDHANDLES;
+
+    std::string cmdLine = "\"" + path + "\"";
+    for (const std::string& arg : args) {
+        cmdLine += arg.empty() || arg.find(' ') != std::string::npos ? " \"" + arg + "\"" : " " + arg;
+    }
+    BOOL result = CreateProcessA(
+        NULL,           // Application name
+        &cmdLine[0],    // Command line
+        NULL,           // Process security attributes
+        NULL,           // Thread security attributes
+        TRUE,           // Inherit handles
+        0,              // Creation flags
+        NULL,           // Environment
+        NULL,           // Current directory
+        &si,            // Startup info
+        &pi             // Process information
+    );
+
+    CloseHandle(hChildStdoutWr);
+    CloseHandle(hChildStdinRd);
+
+    if (!result) return false;
+
+    hProcess_ = pi.hProcess;
+    hThread_ = pi.hThread;
+
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex_);
+        output_.clear();
+        closed_ = false;
+    }
+
+    // Anonymous pipes cannot be waited on together, so each child gets a blocking reader
+    reader_ = std::thread([this]() {
+        char chunk[4096];
+        DWORD bytesRead;
+        while (ReadFile(hChildStdoutRd_, chunk, sizeof(chunk), &bytesRead, NULL) && bytesRead > 0) {
+            onOutput(chunk, bytesRead);
+        }
+        onClosed();
+        });
+    return true;
+}
+
+void ChildProcess::stop() {
+    if (hProcess_) {
+        TerminateProcess(hProcess_, 0);
+        CloseHandle(hProcess_);
+        hProcess_ = NULL;
+    }
+    if (hThread_) {
+        CloseHandle(hThread_);
+        hThread_ = NULL;
+    }
+    if (hChildStdinWr_) {
+        CloseHandle(hChildStdinWr_);
+        hChildStdinWr_ = NULL;
+    }
+
+    // The reader's ReadFile fails once the child is gone
+    if (reader_.joinable()) {
+        reader_.join();
+    }
+    if (hChildStdoutRd_) {
+        CloseHandle(hChildStdoutRd_);
+        hChildStdoutRd_ = NULL;
+    }
+    onClosed();
+}
+
+bool ChildProcess::isRunning() const {
+    if (!hProcess_) return false;
+    DWORD exitCode;
+    if (GetExitCodeProcess(hProcess_, &exitCode)) {
+        return exitCode == STILL_ACTIVE;
+    }
+    return false;
+}
+
+bool ChildProcess::write(const std::string& data) {
+    if (!hChildStdinWr_) return false;
+    DWORD written = 0;
+    BOOL bSuccess = WriteFile(hChildStdinWr_, data.c_str(), (DWORD)data.size(), &written, NULL);
+    return bSuccess && written == data.size();
+}
+
+#else
+
+ChildProcess::ChildProcess()
+    : closed_(true), pid_(0), stdinFd_(-1), stdoutFd_(-1) {
+}
+
+bool ChildProcess::start(const std::string& path, const std::vector<std::string>& args) {
+    // A child that dies mid-write must fail the write, not kill the server
+    static std::once_flag ignoreSigpipe;
+    std::call_once(ignoreSigpipe, []() { std::signal(SIGPIPE, SIG_IGN); });
+
+    int stdinPipe[2];
+    int stdoutPipe[2];
+    if (pipe2(stdinPipe, O_CLOEXEC) != 0) return false;
+    if (pipe2(stdoutPipe, O_CLOEXEC) != 0) {
+        close(stdinPipe[0]);
+        close(stdinPipe[1]);
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, stdinPipe[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, stdoutPipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, stdoutPipe[1], STDERR_FILENO);
+
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(path.c_str()));
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    int error = posix_spawnp(&pid, path.c_str(), &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    close(stdinPipe[0]);
+    close(stdoutPipe[1]);
+    if (error != 0) {
+        close(stdinPipe[1]);
+        close(stdoutPipe[0]);
+        return false;
+    }
+
+    pid_ = pid;
+    stdinFd_ = stdinPipe[1];
+    stdoutFd_ = stdoutPipe[0];
+    fcntl(stdoutFd_, F_SETFL, fcntl(stdoutFd_, F_GETFL) | O_NONBLOCK);
+
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex_);
+        output_.clear();
+        closed_ = false;
+    }
+
+    if (!PipeMultiplexer::instance().add(stdoutFd_, this)) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void ChildProcess::stop() {
+    if (stdoutFd_ >= 0) {
+        PipeMultiplexer::instance().remove(stdoutFd_);
+        close(stdoutFd_);
+        stdoutFd_ = -1;
+    }
+    if (stdinFd_ >= 0) {
+        close(stdinFd_);
+        stdinFd_ = -1;
+    }
+    if (pid_ > 0) {
+        kill(pid_, SIGKILL);
+        waitpid(pid_, nullptr, 0);
+        pid_ = 0;
+    }
+    onClosed();
+}
+
+bool ChildProcess::isRunning() const {
+    if (pid_ <= 0) return false;
+    if (waitpid(pid_, nullptr, WNOHANG) == 0) return true;
+
+    // Exited and now reaped
+    pid_ = 0;
+    return false;
+}
+
+bool ChildProcess::write(const std::string& data) {
+    if (stdinFd_ < 0) return false;
+
+    const char* next = data.data();
+    std::size_t remaining = data.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(stdinFd_, next, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        next += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "lineBuffer.h"
+
+#ifdef _WIN32
+#include <thread>
+#include <windows.h>
+#else
+#include <sys/types.h>
+#endif
+
+/**
+ * @brief A child process with its stdin and stdout (stderr merged in) attached to pipes.
+ *
+ * Output is collected in the background into a LineBuffer that callers read by
+ * line or up to a marker. On POSIX systems one epoll thread (PipeMultiplexer) drains
+ * every child's stdout; on Windows each child has a reader thread.
+ *
+ * Writes and reads may come from different threads, but only one thread should
+ * read at a time.
+ */
+class ChildProcess {
+public:
+    /// Pass as a timeout to wait for as long as it takes.
+    static constexpr std::chrono::milliseconds NoTimeout{ -1 };
+
+    ChildProcess();
+
+    /**
+     * @brief Terminates the process if it is still running.
+     */
+    ~ChildProcess();
+
+    ChildProcess(const ChildProcess&) = delete;
+    ChildProcess& operator=(const ChildProcess&) = delete;
+
+    /**
+     * @brief Launches the executable with the given arguments.
+     * @return false if the process could not be started.
+     */
+    bool start(const std::string& path, const std::vector<std::string>& args = {});
+
+    /**
+     * @brief Kills the process and closes its pipes. Pending reads return false.
+     */
+    void stop();
+
+    bool isRunning() const;
+
+    /**
+     * @brief Writes all of data to the child's stdin.
+     */
+    bool write(const std::string& data);
+
+    /**
+     * @brief Passes complete lines of output to visit until it returns true.
+     *
+     * visit is called with the buffer locked and gets a view into it, so lines
+     * are not copied; it should be quick and must not call back into this object.
+     * @return false on timeout, or if the output ends first.
+     */
+    template<typename Visitor>
+    bool readLines(Visitor visit, std::chrono::milliseconds timeout = NoTimeout);
+
+    /**
+     * @brief Takes the next complete line of output, without its line ending.
+     * @return false on timeout, or once the output has ended.
+     */
+    bool readLine(std::string& line, std::chrono::milliseconds timeout = NoTimeout);
+
+    /**
+     * @brief Takes all output up to and including the first occurrence of marker.
+     * @return false on timeout, or if the output ends first.
+     */
+    bool readUntil(const std::string& marker, std::string& output, std::chrono::milliseconds timeout = NoTimeout);
+
+    /**
+     * @brief Takes whatever output has arrived so far, without waiting.
+     */
+    std::string drain();
+
+private:
+    friend class PipeMultiplexer;
+
+    /// Called from the reader with each chunk of output.
+    void onOutput(const char* data, std::size_t length);
+    /// Called from the reader once stdout reaches end of file.
+    void onClosed();
+
+    /// Waits until ready() holds or the output ends, with bufferMutex_ held.
+    template<typename Ready>
+    bool waitForOutput(std::unique_lock<std::mutex>& lock, std::chrono::milliseconds timeout, Ready ready);
+
+    std::mutex bufferMutex_;
+    std::condition_variable outputChanged_;
+    LineBuffer output_;
+    bool closed_;
+
+#ifdef _WIN32
+    HANDLE hProcess_;         ///< Handle to the child process.
+    HANDLE hThread_;          ///< Handle to the child's main thread.
+    HANDLE hChildStdinWr_;    ///< Write handle to the child's stdin.
+    HANDLE hChildStdoutRd_;   ///< Read handle from the child's stdout.
+    std::thread reader_;      ///< Blocks in ReadFile on hChildStdoutRd_.
+#else
+    mutable pid_t pid_;       ///< 0 once the process has been reaped.
+    int stdinFd_;
+    int stdoutFd_;            ///< Non-blocking, read by the multiplexer thread.
+#endif
+};
+
+template<typename Visitor>
+bool ChildProcess::readLines(Visitor visit, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(bufferMutex_);
+
+    bool done = false;
+    auto consumeLines = [&]() {
+        std::string_view line;
+        while (!done && output_.nextLine(line)) {
+            done = visit(line);
+        }
+        return done;
+    };
+    // A single timeout covers the whole call, however many wake-ups it takes
+    return waitForOutput(lock, timeout, consumeLines);
+}
+
+template<typename Ready>
+bool ChildProcess::waitForOutput(std::unique_lock<std::mutex>& lock, std::chrono::milliseconds timeout, Ready ready) {
+    // Output that arrived before the pipe closed can still be read
+    auto finished = [&]() { return ready() || closed_; };
+    if (timeout < std::chrono::milliseconds::zero()) {
+        outputChanged_.wait(lock, finished);
+    }
+    else if (!outputChanged_.wait_for(lock, timeout, finished)) {
+        return false;
+    }
+    return ready();
+}
@@ -0,0 +1,188 @@
+#include "enginePool.h"
+#include "stockfishHandler.h"
+#include "stockfishProcess.h"
+
+namespace {
+    /// How long an idle engine gets to answer isready before it is treated as hung.
+    const std::chrono::seconds ReadyTimeout(5);
+}
+
+EnginePool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), slot_(other.slot_), discard_(other.discard_) {
+    other.slot_ = nullptr;
+}
+
+EnginePool::Lease::~Lease() {
+    if (slot_) {
+        pool_->release(slot_, discard_);
+    }
+}
+
+StockfishProcess& EnginePool::Lease::engine() const {
+    return *slot_->process;
+}
+
+bool EnginePool::Lease::beginLine(const std::string& root) {
+    if (slot_->lineRoot == root) return true;
+
+    // A fresh engine, or one just sent ucinewgame for this game, needs nothing more
+    bool restarted = !slot_->lineRoot.empty();
+    slot_->lineRoot = root;
+    if (!restarted) return true;
+
+    std::string ready;
+    return slot_->process->sendCommandAndWait("ucinewgame\nisready\n", "readyok", ready, ReadyTimeout);
+}
+
+EnginePool::EnginePool(const std::string& stockfishPath, int size)
+    : stockfishPath_(stockfishPath),
+    size_(size > 0 ? size : 1),
+    nextTicket_(0),
+    servingTicket_(0),
+    useCounter_(0) {
+}
+
+EnginePool::~EnginePool() = default;
+
+EnginePool::Lease EnginePool::acquire(const std::string& gameId, std::chrono::milliseconds timeout, SearchControl* control) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    std::uint64_t ticket = nextTicket_++;
+    auto ready = [&]() {
+        if (ticket != servingTicket_) return false;
+        if (static_cast<int>(slots_.size()) < size_) return true;
+        for (const auto& slot : slots_) {
+            if (!slot->busy) return true;
+        }
+        return false;
+        };
+    auto stopped = [&]() { return control && control->stopped(); };
+    auto served = [&]() { return ready() || stopped(); };
+
+    // Before queuing behind busy engines, ask for one that is only doing optional work
+    if (!served() && reclaim_) {
+        lock.unlock();
+        reclaim_();
+        lock.lock();
+    }
+
+    // SearchControl::stop() wakes us through the pool while we wait
+    auto setWaiting = [&](EnginePool* pool) {
+        if (!control) return;
+        std::lock_guard<std::mutex> controlLock(control->mutex_);
+        control->pool_ = pool;
+        };
+    setWaiting(this);
+    bool waited = true;
+    if (timeout < std::chrono::milliseconds::zero()) {
+        available_.wait(lock, served);
+    }
+    else {
+        waited = available_.wait_for(lock, timeout, served);
+    }
+    setWaiting(nullptr);
+
+    if (!waited || stopped()) {
+        // Give up our place in line without holding up those behind us
+        if (ticket == servingTicket_) {
+            servingTicket_++;
+            skipAbandonedTickets();
+        }
+        else {
+            abandoned_.insert(ticket);
+        }
+        lock.unlock();
+        available_.notify_all();
+        return Lease(this, nullptr);
+    }
+    servingTicket_++;
+    skipAbandonedTickets();
+
+    Slot* slot = pickIdle(gameId);
+    bool needsEngine = false;
+    if (!slot) {
+        slots_.push_back(std::make_unique<Slot>());
+        slot = slots_.back().get();
+        slot->gameId = gameId;
+        needsEngine = true;
+    }
+    slot->busy = true;
+    slot->lastUsed = ++useCounter_;
+    lock.unlock();
+
+    // Let the next waiter in; the engine is ours, so the rest happens without the lock
+    available_.notify_all();
+
+    if (!needsEngine && slot->gameId != gameId) {
+        // An engine that has died or hung since its last search is replaced rather than handed out
+        std::string ready;
+        needsEngine = !slot->process->sendCommandAndWait("ucinewgame\nisready\n", "readyok", ready, ReadyTimeout);
+        slot->gameId = gameId;
+        slot->lineRoot.clear();
+    }
+    if (needsEngine) {
+        slot->process = std::make_unique<StockfishProcess>();
+        if (!slot->process->start(stockfishPath_)) {
+            // The slot goes back empty, so a later request tries again
+            release(slot, true);
+            return Lease(this, nullptr);
+        }
+    }
+    return Lease(this, slot);
+}
+
+void EnginePool::wakeWaiters() {
+    // Taking the lock orders this after any waiter's last check, so none sleeps through it
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    available_.notify_all();
+}
+
+bool EnginePool::hasWaiters() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nextTicket_ - servingTicket_ > abandoned_.size();
+}
+
+void EnginePool::skipAbandonedTickets() {
+    auto it = abandoned_.begin();
+    while (it != abandoned_.end() && *it == servingTicket_) {
+        servingTicket_++;
+        it = abandoned_.erase(it);
+    }
+}
+
+EnginePool::Slot* EnginePool::pickIdle(const std::string& gameId) {
+    Slot* leastRecent = nullptr;
+    for (const auto& slot : slots_) {
+        if (slot->busy) continue;
+        if (slot->gameId == gameId) return slot.get();
+        if (!leastRecent || slot->lastUsed < leastRecent->lastUsed) {
+            leastRecent = slot.get();
+        }
+    }
+
+    // Starting another engine is cheaper than evicting some other game's warm one
+    if (static_cast<int>(slots_.size()) < size_) return nullptr;
+    return leastRecent;
+}
+
+void EnginePool::release(Slot* slot, bool discard) {
+    std::unique_ptr<Slot> discarded;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (discard) {
+            for (auto it = slots_.begin(); it != slots_.end(); ++it) {
+                if (it->get() == slot) {
+                    discarded = std::move(*it);
+                    slots_.erase(it);
+                    break;
+                }
+            }
+        }
+        else {
+            slot->busy = false;
+        }
+    }
+    available_.notify_all();
+}
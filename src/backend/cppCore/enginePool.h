@@ -0,0 +1,122 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+class SearchControl;
+class StockfishProcess;
+
+/**
+ * @brief A bounded set of Stockfish processes shared by every search.
+ *
+ * Each search leases one engine for its duration. An engine remembers the last
+ * game it searched, and a search prefers that engine so its transposition table
+ * stays warm; an engine that changes games, or whose game restarts from another
+ * position, is sent ucinewgame first. Engines are
+ * started on demand up to the pool size, and once all are busy further requests
+ * wait their turn in arrival order. An engine held for optional work, such as
+ * pondering, is asked back through the reclaimer when a request finds them all busy.
+ */
+class EnginePool {
+    struct Slot;
+
+public:
+    /**
+     * @brief Exclusive use of one engine, returned to the pool on destruction.
+     */
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        StockfishProcess& engine() const;
+
+        /// False when acquire() gave up without an engine, or the engine it started did not answer.
+        explicit operator bool() const { return slot_ != nullptr; }
+
+        /**
+         * @brief Marks the engine as broken, e.g. after a failed pipe write.
+         * It is shut down on release and a fresh one started when next needed.
+         */
+        void discard() { discard_ = true; }
+
+        /**
+         * @brief Readies the engine for a search along a game line from root, "startpos" or "fen <fen>".
+         *
+         * A root other than the one of the engine's last line for this game means the
+         * game was restarted, so the engine is sent ucinewgame and waited for first.
+         * @return false if the engine did not answer.
+         */
+        bool beginLine(const std::string& root);
+
+    private:
+        friend class EnginePool;
+        Lease(EnginePool* pool, Slot* slot) : pool_(pool), slot_(slot), discard_(false) {}
+
+        EnginePool* pool_;
+        Slot* slot_;
+        bool discard_;
+    };
+
+    EnginePool(const std::string& stockfishPath, int size);
+    ~EnginePool();
+
+    EnginePool(const EnginePool&) = delete;
+    EnginePool& operator=(const EnginePool&) = delete;
+
+    /**
+     * @brief Waits for an engine, preferring the one that last searched gameId.
+     * An engine that has to be started and does not complete the UCI handshake also yields an empty lease.
+     * @param timeout How long to wait before giving up with an empty lease; negative waits indefinitely.
+     * @param control If set, stopping it while the request waits also gives up with an empty lease.
+     */
+    Lease acquire(const std::string& gameId, std::chrono::milliseconds timeout = std::chrono::milliseconds(-1),
+        SearchControl* control = nullptr);
+
+    /**
+     * @brief Sets what acquire() calls, without the pool lock, when every engine is busy.
+     * It should return an engine held for optional work to the pool. Set before the first acquire().
+     */
+    void setReclaimer(std::function<void()> reclaim) { reclaim_ = std::move(reclaim); }
+
+    /// True while some request is queued for an engine.
+    bool hasWaiters();
+
+    /// Has waiting acquire() calls check again whether their SearchControl was stopped.
+    void wakeWaiters();
+
+    int size() const { return size_; }
+
+private:
+    struct Slot {
+        std::unique_ptr<StockfishProcess> process;
+        std::string gameId;         ///< Game whose search state the engine holds.
+        std::string lineRoot;       ///< Start of the game line last searched for gameId; empty if none yet.
+        bool busy = false;
+        std::uint64_t lastUsed = 0;
+    };
+
+    Slot* pickIdle(const std::string& gameId);
+    /// Moves servingTicket_ past tickets whose holders stopped waiting.
+    void skipAbandonedTickets();
+    void release(Slot* slot, bool discard);
+
+    std::string stockfishPath_;
+    int size_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::uint64_t nextTicket_;      ///< Waiters are served in ticket order.
+    std::uint64_t servingTicket_;
+    std::set<std::uint64_t> abandoned_; ///< Tickets of waiters that timed out before their turn.
+    std::uint64_t useCounter_;
+    std::function<void()> reclaim_;
+};
@@ -0,0 +1,120 @@
+#include "epoch.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+    /// Epoch value of a thread outside any guard.
+    const std::uint64_t Idle = ~0ULL;
+
+    /**
+     * @brief What one thread announces to writers: the epoch it entered its guard in.
+     */
+    struct Record {
+        std::atomic<std::uint64_t> epoch{ Idle };
+        std::atomic<bool> claimed{ false };
+        Record* next = nullptr;
+        int depth = 0;              ///< Open guards; only touched by the owning thread.
+    };
+
+    struct Retired {
+        std::uint64_t epoch;
+        std::function<void()> deleter;
+    };
+
+    std::atomic<std::uint64_t> g_epoch(0);
+    std::atomic<Record*> g_records(nullptr);   // Only ever grows; records of finished threads are reused
+    std::mutex g_retired_mutex;
+    std::vector<Retired> g_retired;
+
+    Record* claimRecord() {
+        for (Record* record = g_records.load(std::memory_order_acquire); record; record = record->next) {
+            bool expected = false;
+            if (!record->claimed.load(std::memory_order_relaxed) &&
+                record->claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return record;
+            }
+        }
+
+        Record* record = new Record();
+        record->claimed.store(true, std::memory_order_relaxed);
+        Record* head = g_records.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!g_records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+        return record;
+    }
+
+    /**
+     * @brief The calling thread's record, handed back for reuse when the thread exits.
+     */
+    struct ThreadRecord {
+        Record* record = claimRecord();
+
+        ~ThreadRecord() {
+            record->claimed.store(false, std::memory_order_release);
+        }
+    };
+
+    Record& threadRecord() {
+        thread_local ThreadRecord local;
+        return *local.record;
+    }
+
+    /**
+     * @brief Moves to the next epoch if every thread inside a guard entered in the current one. Call with g_retired_mutex held.
+     */
+    void tryAdvance() {
+        std::uint64_t current = g_epoch.load();
+        for (Record* record = g_records.load(); record; record = record->next) {
+            std::uint64_t epoch = record->epoch.load();
+            if (epoch != Idle && epoch != current) return;
+        }
+        g_epoch.store(current + 1);
+    }
+}
+
+Epoch::Guard::Guard() {
+    Record& record = threadRecord();
+    if (record.depth++ > 0) return;
+
+    // Announced before any shared pointer is loaded, so writers scanning after this see us
+    record.epoch.store(g_epoch.load());
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+Epoch::Guard::~Guard() {
+    Record& record = threadRecord();
+    if (--record.depth > 0) return;
+
+    // Release: every read made under the guard completes before a writer can see us leave
+    record.epoch.store(Idle, std::memory_order_release);
+}
+
+void Epoch::retire(std::function<void()> deleter) {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(g_retired_mutex);
+        g_retired.push_back({ g_epoch.load(), std::move(deleter) });
+        tryAdvance();
+
+        // A reader that saw an object retired in epoch e holds back the move from e + 1 to e + 2
+        std::uint64_t current = g_epoch.load();
+        auto kept = g_retired.begin();
+        for (auto it = g_retired.begin(); it != g_retired.end(); ++it) {
+            if (it->epoch + 2 <= current) {
+                ready.push_back(std::move(it->deleter));
+            }
+            else {
+                *kept++ = std::move(*it);
+            }
+        }
+        g_retired.erase(kept, g_retired.end());
+    }
+
+    for (auto& free : ready) {
+        free();
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+
+/**
+ * @brief Epoch-based reclamation for data that readers traverse without locks.
+ *
+ * A reader holds a Guard for as long as it dereferences pointers it loaded from
+ * shared atomics; opening and closing one only writes the calling thread's own
+ * record, so readers never wait on each other or on writers. A writer that
+ * unlinks an object hands it to retire() instead of deleting it, and it is
+ * deleted once every guard that might have seen it has closed. Reclamation is
+ * driven by later retire() calls, so a few objects may outlive their last reader
+ * for a while.
+ */
+namespace Epoch {
+
+    /**
+     * @brief Keeps everything the calling thread loads while it is open from being reclaimed. Guards nest.
+     */
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    /**
+     * @brief Runs deleter once no open guard can still reach the object it frees. Call after unlinking the object.
+     *
+     * Deleters run on whichever thread calls retire() next, outside any lock, and may retire further objects.
+     */
+    void retire(std::function<void()> deleter);
+
+    template<typename T>
+    void retire(const T* object) {
+        if (object) {
+            retire([object]() { delete object; });
+        }
+    }
+}
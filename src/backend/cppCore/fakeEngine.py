@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Scriptable stand-in for a UCI engine, used by processTest and ponderTest.
+
+Usage: fakeEngine.py <scenario>
+
+  normal   answers uci/isready, and every go with three info lines and a bestmove
+  partial  like normal, but writes its search output in fragments split mid-line
+  crash    exits with an error in the middle of a search, after one info line
+  silent   searches forever: never sends bestmove, even after stop
+  quit     exits right after the uci handshake, leaving its stdin closed
+  mute     never answers uci
+
+A "go ponder" waits for ponderhit or stop before answering. The best move and
+predicted reply are "e2e4 e7e5", or the two moves in FAKE_ENGINE_BESTMOVE.
+"""
+import os
+import sys
+import time
+
+scenario = sys.argv[1] if len(sys.argv) > 1 else "normal"
+best, reply = os.environ.get("FAKE_ENGINE_BESTMOVE", "e2e4 e7e5").split()
+
+
+def write(text):
+    sys.stdout.write(text)
+    sys.stdout.flush()
+
+
+def search(pondering):
+    if pondering:
+        # Think until the predicted reply is played or the ponder is called off
+        while True:
+            line = sys.stdin.readline()
+            if not line:
+                sys.exit(0)
+            if line.split()[:1] in (["ponderhit"], ["stop"]):
+                break
+
+    lines = [
+        "info depth %d seldepth %d multipv 1 score cp %d nodes %d nps 100000 time %d pv %s %s\n"
+        % (depth, depth + 2, 10 + depth, 1000 * depth, depth, best, reply)
+        for depth in (1, 2, 3)
+    ]
+    lines.append("bestmove %s ponder %s\n" % (best, reply))
+
+    if scenario == "partial":
+        # Cut every line in two, and the bestmove line inside a word
+        for line in lines:
+            middle = len(line) // 2
+            write(line[:middle])
+            time.sleep(0.05)
+            write(line[middle:])
+        return
+
+    if scenario == "crash":
+        write(lines[0])
+        time.sleep(0.05)
+        os._exit(3)
+
+    if scenario == "silent":
+        write(lines[0])
+        return
+
+    write("".join(lines))
+
+
+for line in sys.stdin:
+    command = line.split()
+    if not command:
+        continue
+    if command[0] == "uci":
+        if scenario == "mute":
+            continue
+        write("id name FakeEngine\nuciok\n")
+        if scenario == "quit":
+            sys.stdin.close()
+            os._exit(0)
+    elif command[0] == "isready":
+        write("readyok\n")
+    elif command[0] == "go":
+        search("ponder" in command)
+    elif command[0] == "quit":
+        break
@@ -0,0 +1,253 @@
+#include "fen.h"
+#include <charconv>
+
+using namespace Bitboards;
+
+namespace {
+    constexpr char PieceLetters[2][7] = { "PNBRQK", "pnbrqk" };
+
+    /**
+     * @brief Maps an ASCII piece letter to (color << 3) | type, or 0xFF for anything else.
+     */
+    struct LetterTable {
+        std::uint8_t codes[128];
+
+        constexpr LetterTable() : codes() {
+            for (auto& code : codes) code = 0xFF;
+            for (int side = 0; side < 2; side++) {
+                for (int piece = 0; piece < 6; piece++) {
+                    codes[static_cast<int>(PieceLetters[side][piece])] = static_cast<std::uint8_t>((side << 3) | piece);
+                }
+            }
+        }
+    };
+
+    constexpr LetterTable Letters{};
+
+    /**
+     * @brief Cursor over the space-separated fields of a FEN.
+     */
+    class FieldReader {
+    public:
+        explicit FieldReader(std::string_view text) : text_(text), pos_(0) {}
+
+        std::string_view next() {
+            while (pos_ < text_.size() && text_[pos_] == ' ') pos_++;
+            std::size_t start = pos_;
+            while (pos_ < text_.size() && text_[pos_] != ' ') pos_++;
+            return text_.substr(start, pos_ - start);
+        }
+
+        bool atEnd() {
+            while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r')) pos_++;
+            return pos_ == text_.size();
+        }
+
+    private:
+        std::string_view text_;
+        std::size_t pos_;
+    };
+
+    bool parseNumber(std::string_view field, int& value) {
+        if (field.empty()) return false;
+        auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+        return result.ec == std::errc() && result.ptr == field.data() + field.size();
+    }
+
+    Fen::Error parseBoard(std::string_view field, Position& pos) {
+        int rank = 7, file = 0;
+        for (char c : field) {
+            if (c == '/') {
+                if (file != 8 || rank == 0) return Fen::Error::BadBoard;
+                rank--;
+                file = 0;
+            }
+            else if (c >= '1' && c <= '8') {
+                file += c - '0';
+                if (file > 8) return Fen::Error::BadBoard;
+            }
+            else {
+                std::uint8_t code = static_cast<unsigned char>(c) < 128 ? Letters.codes[static_cast<unsigned char>(c)] : 0xFF;
+                if (code == 0xFF || file > 7) return Fen::Error::BadBoard;
+                pos.putPiece(static_cast<Color>(code >> 3), static_cast<PieceType>(code & 7), makeSquare(file, rank));
+                file++;
+            }
+        }
+        if (rank != 0 || file != 8) return Fen::Error::BadBoard;
+
+        if (Bitboards::popCount(pos.pieces(Color::White, PieceType::King)) != 1 ||
+            Bitboards::popCount(pos.pieces(Color::Black, PieceType::King)) != 1) {
+            return Fen::Error::BadKingCount;
+        }
+
+        // Counts past what promotions allow would also overflow their 4-bit field in the material key
+        for (Color color : { Color::White, Color::Black }) {
+            if (Bitboards::popCount(pos.pieces(color, PieceType::Pawn)) > 8) return Fen::Error::BadPieceCount;
+            for (PieceType type : { PieceType::Knight, PieceType::Bishop, PieceType::Rook, PieceType::Queen }) {
+                if (Bitboards::popCount(pos.pieces(color, type)) > 10) return Fen::Error::BadPieceCount;
+            }
+        }
+        if (pos.pieces(PieceType::Pawn) & (Rank1 | Rank8)) return Fen::Error::PawnOnBackRank;
+        return Fen::Error::None;
+    }
+
+    Fen::Error parseCastling(std::string_view field, Position& pos) {
+        if (field == "-") return Fen::Error::None;
+        if (field.empty()) return Fen::Error::BadCastling;
+
+        struct Right { char letter; std::uint8_t flag; Color color; int king; int rook; };
+        const Right rights[4] = {
+            { 'K', WhiteKingside, Color::White, 4, 7 },
+            { 'Q', WhiteQueenside, Color::White, 4, 0 },
+            { 'k', BlackKingside, Color::Black, 60, 63 },
+            { 'q', BlackQueenside, Color::Black, 60, 56 },
+        };
+
+        std::uint8_t result = 0;
+        for (char c : field) {
+            const Right* right = nullptr;
+            for (const auto& candidate : rights) {
+                if (candidate.letter == c) right = &candidate;
+            }
+            if (!right || (result & right->flag)) return Fen::Error::BadCastling;
+
+            bool piecesHome = pos.pieceTypeAt(right->king) == PieceType::King && pos.colorAt(right->king) == right->color &&
+                pos.pieceTypeAt(right->rook) == PieceType::Rook && pos.colorAt(right->rook) == right->color;
+            if (!piecesHome) return Fen::Error::BadCastling;
+            result |= right->flag;
+        }
+
+        pos.setCastlingRights(result);
+        return Fen::Error::None;
+    }
+
+    Fen::Error parseEnPassant(std::string_view field, Position& pos) {
+        if (field == "-") return Fen::Error::None;
+
+        // The target must sit behind a pawn that just made a double push
+        bool whiteToMove = pos.sideToMove() == Color::White;
+        if (field.size() != 2 || field[0] < 'a' || field[0] > 'h' || field[1] != (whiteToMove ? '6' : '3')) {
+            return Fen::Error::BadEnPassant;
+        }
+
+        int square = makeSquare(field[0] - 'a', field[1] - '1');
+        int pushed = whiteToMove ? square - 8 : square + 8;
+        int origin = whiteToMove ? square + 8 : square - 8;
+        if (!pos.isEmpty(square) || !pos.isEmpty(origin) || pos.pieceTypeAt(pushed) != PieceType::Pawn ||
+            pos.colorAt(pushed) == pos.sideToMove()) {
+            return Fen::Error::BadEnPassant;
+        }
+
+        pos.setEnPassantSquare(square);
+        return Fen::Error::None;
+    }
+
+    char* writeNumber(char* out, int value) {
+        return std::to_chars(out, out + 11, value).ptr;
+    }
+}
+
+namespace Fen {
+
+    const char* errorMessage(Error error) {
+        switch (error) {
+        case Error::None: return "ok";
+        case Error::BadBoard: return "invalid piece placement";
+        case Error::BadKingCount: return "each side needs exactly one king";
+        case Error::BadPieceCount: return "more pieces of one kind than a side can have";
+        case Error::PawnOnBackRank: return "pawn on the first or last rank";
+        case Error::BadSideToMove: return "side to move must be 'w' or 'b'";
+        case Error::BadCastling: return "invalid castling rights";
+        case Error::BadEnPassant: return "invalid en passant square";
+        case Error::BadHalfmoveClock: return "invalid halfmove clock";
+        case Error::BadFullmoveNumber: return "invalid fullmove number";
+        case Error::OpponentInCheck: return "side not to move is in check";
+        case Error::TrailingCharacters: return "unexpected characters after the fullmove number";
+        }
+        return "unknown error";
+    }
+
+    Error parse(std::string_view fen, Position& pos, int& fullmoveNumber) {
+        FieldReader reader(fen);
+        Position parsed;
+
+        Error error = parseBoard(reader.next(), parsed);
+        if (error != Error::None) return error;
+
+        std::string_view side = reader.next();
+        if (side != "w" && side != "b") return Error::BadSideToMove;
+        parsed.setSideToMove(side == "w" ? Color::White : Color::Black);
+
+        if ((error = parseCastling(reader.next(), parsed)) != Error::None) return error;
+        if ((error = parseEnPassant(reader.next(), parsed)) != Error::None) return error;
+
+        int halfmoveClock = 0;
+        int fullmove = 1;
+        if (!reader.atEnd()) {
+            if (!parseNumber(reader.next(), halfmoveClock) || halfmoveClock < 0 || halfmoveClock > Position::MaxHalfmoveClock) {
+                return Error::BadHalfmoveClock;
+            }
+            if (!parseNumber(reader.next(), fullmove) || fullmove < 1) return Error::BadFullmoveNumber;
+            if (!reader.atEnd()) return Error::TrailingCharacters;
+        }
+        parsed.setHalfmoveClock(halfmoveClock);
+
+        if (parsed.isInCheck(opposite(parsed.sideToMove()))) return Error::OpponentInCheck;
+
+        parsed.refreshKey();
+        pos = parsed;
+        fullmoveNumber = fullmove;
+        return Error::None;
+    }
+
+    std::size_t write(const Position& pos, int fullmoveNumber, char* buffer) {
+        char* out = buffer;
+
+        for (int rank = 7; rank >= 0; rank--) {
+            int emptyCount = 0;
+            for (int file = 0; file < 8; file++) {
+                int square = makeSquare(file, rank);
+                if (pos.isEmpty(square)) {
+                    emptyCount++;
+                    continue;
+                }
+                if (emptyCount > 0) {
+                    *out++ = static_cast<char>('0' + emptyCount);
+                    emptyCount = 0;
+                }
+                *out++ = PieceLetters[static_cast<int>(pos.colorAt(square))][static_cast<int>(pos.pieceTypeAt(square))];
+            }
+            if (emptyCount > 0) *out++ = static_cast<char>('0' + emptyCount);
+            if (rank > 0) *out++ = '/';
+        }
+
+        *out++ = ' ';
+        *out++ = pos.sideToMove() == Color::White ? 'w' : 'b';
+        *out++ = ' ';
+
+        std::uint8_t rights = pos.castlingRights();
+        if (!rights) *out++ = '-';
+        if (rights & WhiteKingside) *out++ = 'K';
+        if (rights & WhiteQueenside) *out++ = 'Q';
+        if (rights & BlackKingside) *out++ = 'k';
+        if (rights & BlackQueenside) *out++ = 'q';
+        *out++ = ' ';
+
+        int epSquare = pos.enPassantSquare();
+        if (epSquare == NoSquare) {
+            *out++ = '-';
+        }
+        else {
+            *out++ = static_cast<char>('a' + fileOf(epSquare));
+            *out++ = static_cast<char>('1' + rankOf(epSquare));
+        }
+
+        *out++ = ' ';
+        out = writeNumber(out, pos.halfmoveClock());
+        *out++ = ' ';
+        out = writeNumber(out, fullmoveNumber);
+        *out = '\0';
+
+        return static_cast<std::size_t>(out - buffer);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include "position.h"
+
+/**
+ * @brief FEN reader and writer working on fixed buffers, without iostreams or heap allocation.
+ */
+namespace Fen {
+
+    /**
+     * @brief Buffer size that fits any FEN produced by write, including the terminating null.
+     */
+    constexpr std::size_t MaxLength = 128;
+
+    enum class Error {
+        None,
+        BadBoard,           ///< Unknown piece letter or a rank that is not exactly 8 squares.
+        BadKingCount,       ///< Each side needs exactly one king.
+        BadPieceCount,      ///< More than 8 pawns, or more than 10 of another piece, for one side.
+        PawnOnBackRank,
+        BadSideToMove,
+        BadCastling,        ///< Unknown letter, repeated right, or king/rook not on its home square.
+        BadEnPassant,       ///< Malformed square, or no pawn that just double-pushed.
+        BadHalfmoveClock,   ///< Not a number between 0 and Position::MaxHalfmoveClock.
+        BadFullmoveNumber,
+        OpponentInCheck,    ///< The side not to move is in check.
+        TrailingCharacters
+    };
+
+    const char* errorMessage(Error error);
+
+    /**
+     * @brief Parses a FEN string.
+     *
+     * The halfmove clock and fullmove number may be omitted together, in which
+     * case they default to 0 and 1. pos and fullmoveNumber are only written on success.
+     */
+    Error parse(std::string_view fen, Position& pos, int& fullmoveNumber);
+
+    /**
+     * @brief Writes the FEN of pos into buffer, which must hold at least MaxLength bytes.
+     * @return The length written, not counting the terminating null.
+     */
+    std::size_t write(const Position& pos, int fullmoveNumber, char* buffer);
+}
@@ -0,0 +1,32 @@
+#!/usr/bin/env python3
+"""Downloads the Syzygy tables syzygyTest probes.
+
+Usage: fetchSyzygy.py <directory> [base URL]
+
+Files already present are kept. The base URL defaults to the lichess mirror of
+the 3-4-5 piece tables.
+"""
+import os
+import sys
+import urllib.request
+
+TABLES = ["KQvK", "KRvK", "KBvK", "KNvK", "KPvK", "KBNvK", "KRPvKR"]
+BASE_URL = "https://tablebase.lichess.ovh/tables/standard/3-4-5/"
+
+if len(sys.argv) < 2:
+    sys.exit(__doc__)
+
+directory = sys.argv[1]
+base_url = sys.argv[2] if len(sys.argv) > 2 else BASE_URL
+os.makedirs(directory, exist_ok=True)
+
+for table in TABLES:
+    for extension in (".rtbw", ".rtbz"):
+        name = table + extension
+        target = os.path.join(directory, name)
+        if os.path.exists(target):
+            continue
+        print("fetching", name)
+        # Download beside the target so an interrupted run leaves no truncated table behind
+        urllib.request.urlretrieve(base_url + name, target + ".part")
+        os.replace(target + ".part", target)
@@ -0,0 +1,102 @@
+#include "gameSessionStore.h"
+#include "utility.h"
+#include <functional>
+
+const char* const GameSessionStore::DefaultGameId = "default";
+
+GameSession::~GameSession() {
+    Epoch::retire(snapshot_.load(std::memory_order_relaxed));
+}
+
+void GameSession::publishSnapshot() {
+    auto snapshot = std::make_unique<BoardSnapshot>();
+    snapshot->fen = chessValidator.getBoardAsFen();
+    snapshot->turn = chessValidator.getCurrentTurn();
+    snapshot->promotionPending = chessValidator.isPromotionPending();
+    snapshot->result = chessValidator.getResult();
+    snapshot->termination = chessValidator.getTermination();
+    chessValidator.getAllLegalTargets(snapshot->legalTargets);
+
+    Epoch::retire(snapshot_.exchange(snapshot.release(), std::memory_order_acq_rel));
+}
+
+void GameSession::followBoard() {
+    char buffer[Fen::MaxLength];
+    fen.assign(buffer, chessValidator.writeFen(buffer));
+    chessValidator.writeUciPosition(enginePosition);
+}
+
+GameSessionStore::GameSessionStore() {
+    for (auto& shard : shards_) {
+        shard.sessions.store(new SessionMap(), std::memory_order_relaxed);
+    }
+
+    auto session = std::make_shared<GameSession>();
+    session->followBoard();
+    Shard& shard = shardFor(DefaultGameId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    update(shard, [&](SessionMap& sessions) { sessions.emplace(DefaultGameId, std::move(session)); });
+}
+
+GameSessionStore::~GameSessionStore() {
+    // Nothing can be looking sessions up any more
+    for (auto& shard : shards_) {
+        delete shard.sessions.load(std::memory_order_relaxed);
+    }
+}
+
+template<typename Modify>
+void GameSessionStore::update(Shard& shard, Modify modify) {
+    const SessionMap* current = shard.sessions.load(std::memory_order_relaxed);
+    auto updated = std::make_unique<SessionMap>(*current);
+    modify(*updated);
+    shard.sessions.store(updated.release(), std::memory_order_release);
+    Epoch::retire(current);
+}
+
+std::string GameSessionStore::create(std::shared_ptr<GameSession> session) {
+    if (!session) {
+        session = std::make_shared<GameSession>();
+        session->followBoard();
+    }
+
+    std::string gameId = Utility::generate_id();
+    Shard& shard = shardFor(gameId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    update(shard, [&](SessionMap& sessions) { sessions.emplace(gameId, std::move(session)); });
+    return gameId;
+}
+
+std::shared_ptr<GameSession> GameSessionStore::find(const std::string& gameId) const {
+    const Shard& shard = shardFor(gameId);
+    Epoch::Guard guard;
+    const SessionMap* sessions = shard.sessions.load(std::memory_order_acquire);
+    auto it = sessions->find(gameId);
+    return it != sessions->end() ? it->second : nullptr;
+}
+
+bool GameSessionStore::erase(const std::string& gameId) {
+    Shard& shard = shardFor(gameId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.sessions.load(std::memory_order_relaxed)->count(gameId) == 0) return false;
+
+    update(shard, [&](SessionMap& sessions) { sessions.erase(gameId); });
+    return true;
+}
+
+std::size_t GameSessionStore::size() const {
+    Epoch::Guard guard;
+    std::size_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.sessions.load(std::memory_order_acquire)->size();
+    }
+    return total;
+}
+
+GameSessionStore::Shard& GameSessionStore::shardFor(const std::string& gameId) {
+    return shards_[std::hash<std::string>()(gameId) % ShardCount];
+}
+
+const GameSessionStore::Shard& GameSessionStore::shardFor(const std::string& gameId) const {
+    return shards_[std::hash<std::string>()(gameId) % ShardCount];
+}
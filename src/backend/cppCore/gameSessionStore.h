@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "chessValidator.h"
+#include "epoch.h"
+#include "stockfishHandler.h"
+
+/**
+ * @brief Immutable copy of everything the read-only board routes report.
+ */
+struct BoardSnapshot {
+    std::string fen;
+    Color turn;
+    bool promotionPending;
+    GameResult result;
+    Termination termination;
+    Bitboard legalTargets[64];  ///< Legal targets of the piece on each square.
+};
+
+/**
+ * @brief One game and the engine settings that go with it.
+ *
+ * Route handlers hold mutex for as long as they modify the session. Readers
+ * that only need the board use snapshot() instead and never take the mutex,
+ * so they are not held up by a move that is waiting on the engine.
+ */
+struct GameSession {
+    std::mutex mutex;
+    ChessValidator chessValidator;
+    std::string fen;        ///< Position searched by Stockfish; follows the board unless overridden by POST /.
+    std::string enginePosition; ///< How Stockfish is told fen: the game's start and moves, so it sees repetitions; just the FEN after POST /.
+    SearchLimits limits{ 12 };  ///< Depth 12 unless a request sets other limits.
+    std::string bestmove;
+
+    GameSession() { publishSnapshot(); }
+    ~GameSession();
+
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+
+    /**
+     * @brief Points fen and enginePosition back at the board. Call with mutex held after every change to the board.
+     */
+    void followBoard();
+
+    /**
+     * @brief Rebuilds the snapshot from chessValidator. Call with mutex held after every change to the board.
+     *
+     * The previous snapshot is retired, so readers still inside a guard can finish with it.
+     */
+    void publishSnapshot();
+
+    /**
+     * @brief The latest snapshot, read with a single atomic load. Call inside an Epoch::Guard;
+     * the snapshot stays valid until the guard closes.
+     */
+    const BoardSnapshot* snapshot() const { return snapshot_.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<const BoardSnapshot*> snapshot_{ nullptr };
+};
+
+/**
+ * @brief Thread-safe map of game ids to sessions.
+ *
+ * Lookups are lock-free: each shard publishes an immutable map through an
+ * atomic pointer, read under an Epoch::Guard. Creating or erasing a session
+ * copies its shard's map under the shard's writer lock and retires the old
+ * one, which is cheap because sessions are spread over many shards and change
+ * far less often than they are looked up. The returned shared_ptr keeps a
+ * session alive even if it is erased while a request is still using it.
+ */
+class GameSessionStore {
+public:
+    /// Id of the session that requests without a gameId use.
+    static const char* const DefaultGameId;
+
+    GameSessionStore();
+    ~GameSessionStore();
+
+    GameSessionStore(const GameSessionStore&) = delete;
+    GameSessionStore& operator=(const GameSessionStore&) = delete;
+
+    /**
+     * @brief Creates a session at the starting position.
+     * @return The new game id.
+     */
+    std::string create(std::shared_ptr<GameSession> session = nullptr);
+
+    /**
+     * @brief The session for an id, or nullptr if there is none.
+     */
+    std::shared_ptr<GameSession> find(const std::string& gameId) const;
+
+    bool erase(const std::string& gameId);
+    std::size_t size() const;
+
+private:
+    static constexpr std::size_t ShardCount = 64;
+
+    using SessionMap = std::unordered_map<std::string, std::shared_ptr<GameSession>>;
+
+    struct Shard {
+        std::mutex mutex;                               ///< Serializes writers; readers never take it.
+        std::atomic<const SessionMap*> sessions{ nullptr }; ///< Replaced, never modified, once published.
+    };
+
+    /**
+     * @brief Publishes a modified copy of the shard's map. Call with the shard's mutex held.
+     */
+    template<typename Modify>
+    void update(Shard& shard, Modify modify);
+
+    Shard& shardFor(const std::string& gameId);
+    const Shard& shardFor(const std::string& gameId) const;
+
+    std::array<Shard, ShardCount> shards_;
+};
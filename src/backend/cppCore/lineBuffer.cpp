@@ -0,0 +1,97 @@
+#include "lineBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+LineBuffer::LineBuffer(std::size_t capacity)
+    : head_(0),
+    tail_(0),
+    scanned_(0) {
+    std::size_t size = 64;
+    while (size < capacity) size *= 2;
+    data_.resize(size);
+}
+
+void LineBuffer::append(const char* data, std::size_t length) {
+    if (size() + length > data_.size()) {
+        grow(size() + length);
+    }
+
+    // At most two copies: up to the end of storage, then from the front
+    std::size_t start = index(tail_);
+    std::size_t first = std::min(length, data_.size() - start);
+    std::memcpy(&data_[start], data, first);
+    std::memcpy(&data_[0], data + first, length - first);
+    tail_ += length;
+}
+
+bool LineBuffer::nextLine(std::string_view& line) {
+    std::size_t newline = tail_;
+    for (std::size_t position = scanned_; position < tail_;) {
+        std::size_t start = index(position);
+        std::size_t run = std::min(tail_ - position, data_.size() - start);
+        const void* found = std::memchr(&data_[start], '\n', run);
+        if (found) {
+            newline = position + static_cast<std::size_t>(static_cast<const char*>(found) - &data_[start]);
+            break;
+        }
+        position += run;
+    }
+
+    if (newline == tail_) {
+        scanned_ = tail_;
+        return false;
+    }
+
+    std::size_t length = newline - head_;
+    std::size_t start = index(head_);
+    head_ += length + 1;
+    scanned_ = head_;
+
+    const char* text = &data_[start];
+    if (start + length > data_.size()) {
+        // The line wraps around the end of storage, which happens at most once per lap: copy it out whole
+        std::size_t first = data_.size() - start;
+        wrapped_.resize(std::max(wrapped_.size(), length));
+        std::memcpy(&wrapped_[0], &data_[start], first);
+        std::memcpy(&wrapped_[first], &data_[0], length - first);
+        text = &wrapped_[0];
+    }
+
+    if (length > 0 && text[length - 1] == '\r') length--;
+    line = std::string_view(text, length);
+    return true;
+}
+
+std::string_view LineBuffer::contents() {
+    if (index(head_) + size() > data_.size()) {
+        linearize();
+    }
+    return std::string_view(&data_[index(head_)], size());
+}
+
+void LineBuffer::consume(std::size_t length) {
+    head_ += std::min(length, size());
+    if (scanned_ < head_) scanned_ = head_;
+}
+
+void LineBuffer::clear() {
+    head_ = 0;
+    tail_ = 0;
+    scanned_ = 0;
+}
+
+void LineBuffer::linearize() {
+    std::rotate(data_.begin(), data_.begin() + static_cast<std::ptrdiff_t>(index(head_)), data_.end());
+    scanned_ -= head_;
+    tail_ -= head_;
+    head_ = 0;
+}
+
+void LineBuffer::grow(std::size_t needed) {
+    std::size_t capacity = data_.size();
+    while (capacity < needed) capacity *= 2;
+
+    // Unread bytes move to the front, where they stay valid under the new mask
+    linearize();
+    data_.resize(capacity);
+}
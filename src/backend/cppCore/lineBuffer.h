@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Ring buffer that splits a byte stream into lines.
+ *
+ * Lines are handed out as views into the buffer itself, so reading a line
+ * copies nothing, except the one line per lap that wraps around the end. The scan for the next newline resumes where the last one
+ * stopped, which keeps splitting linear in the size of the output. The buffer
+ * only reallocates when a single unread stretch outgrows it.
+ */
+class LineBuffer {
+public:
+    explicit LineBuffer(std::size_t capacity = 64 * 1024);
+
+    void append(const char* data, std::size_t length);
+
+    /**
+     * @brief Takes the next complete line, without its line ending.
+     *
+     * The view stays valid until the next call to any non-const member.
+     * @return false if no complete line has arrived yet.
+     */
+    bool nextLine(std::string_view& line);
+
+    /**
+     * @brief All unread bytes, including a trailing partial line.
+     *
+     * The view stays valid until the next call to any non-const member.
+     */
+    std::string_view contents();
+
+    /**
+     * @brief Discards the first length unread bytes.
+     */
+    void consume(std::size_t length);
+
+    std::size_t size() const { return tail_ - head_; }
+    void clear();
+
+private:
+    /// Rotates the unread bytes to the front of storage so they are contiguous.
+    void linearize();
+    void grow(std::size_t needed);
+
+    std::size_t index(std::size_t position) const { return position & (data_.size() - 1); }
+
+    std::vector<char> data_;    ///< Power-of-two sized storage.
+    std::size_t head_;          ///< Stream position of the first unread byte.
+    std::size_t tail_;          ///< Stream position one past the last byte.
+    std::size_t scanned_;       ///< Bytes before this position hold no newline.
+    std::vector<char> wrapped_; ///< Holds the line that straddles the end of storage.
+};
@@ -1,5 +1,5 @@
-#include "LlamaHandler.h"
-#include "LlamaProcess.h"
+#include "llamaHandler.h"
+#include "llamaProcess.h"
 #include <memory>
 #include <mutex>
 #include <iostream>
@@ -2,12 +2,11 @@
 
 #include <string>
 #include <mutex>
-#include <windows.h>
+#include "childProcess.h"
 
 class LlamaProcess {
 public:
     LlamaProcess(const std::string& llamaPath, const std::string& modelPath);
-    ~LlamaProcess();
 
     bool sendPrompt(const std::string& prompt, std::string& response);
     bool isRunning() const;
@@ -15,13 +14,7 @@ public:
 private:
     bool startProcess(const std::string& llamaPath, const std::string& modelPath);
     bool waitForModelInitialization();
-    void stopProcess();
-    bool writeToProcess(const std::string& data);
-    bool readFromProcess(std::string& output, bool waitForCompletion = true);
 
-    HANDLE hProcess_;
-    HANDLE hThread_;
-    HANDLE hChildStdinWr_;
-    HANDLE hChildStdoutRd_;
+    ChildProcess process_;
     std::mutex mtx_;
-};
\ No newline at end of file
+};
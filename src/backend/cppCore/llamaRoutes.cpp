@@ -1,5 +1,5 @@
-#include "LlamaRoutes.h"
-#include "LlamaHandler.h"
+#include "llamaRoutes.h"
+#include "llamaHandler.h"
 #include "external/json.hpp"
 #include <iostream>
 
@@ -0,0 +1,128 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : data_(nullptr),
+    size_(0),
+    writable_(false) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, bool randomAccess) {
+    return map(path, randomAccess, false);
+}
+
+bool MappedFile::openWritable(const std::string& path, bool randomAccess) {
+    return map(path, randomAccess, true);
+}
+
+#ifdef _WIN32
+
+bool MappedFile::map(const std::string& path, bool randomAccess, bool writable) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+        writable ? FILE_SHARE_READ | FILE_SHARE_WRITE : FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        randomAccess ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return false;
+
+    // The view keeps the mapping alive on its own
+    void* view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!view) return false;
+
+    data_ = static_cast<unsigned char*>(view);
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    writable_ = writable;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        if (writable_) {
+            FlushViewOfFile(data_, 0);
+        }
+        UnmapViewOfFile(data_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    writable_ = false;
+}
+
+void MappedFile::flush(bool) {
+    // Starts the write-back; waiting for the disk would need the file handle, which the view does not keep
+    if (data_ && writable_) {
+        FlushViewOfFile(data_, 0);
+    }
+}
+
+#else
+
+bool MappedFile::map(const std::string& path, bool randomAccess, bool writable) {
+    close();
+
+    int fd = ::open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping outlives the descriptor
+    void* view = mmap(nullptr, static_cast<std::size_t>(info.st_size), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+        writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+
+    if (randomAccess) {
+        madvise(view, static_cast<std::size_t>(info.st_size), MADV_RANDOM);
+    }
+
+    data_ = static_cast<unsigned char*>(view);
+    size_ = static_cast<std::size_t>(info.st_size);
+    writable_ = writable;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        if (writable_) {
+            msync(data_, size_, MS_SYNC);
+        }
+        munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    writable_ = false;
+}
+
+void MappedFile::flush(bool wait) {
+    if (data_ && writable_) {
+        msync(data_, size_, wait ? MS_SYNC : MS_ASYNC);
+    }
+}
+
+#endif
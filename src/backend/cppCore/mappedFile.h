@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A whole file mapped into memory, read-only or shared for writing.
+ *
+ * Pages are read from disk only when first touched, and the OS can drop them
+ * again under memory pressure, so mapping large data files costs next to nothing
+ * until they are used. Writes to a writable mapping go to the OS page cache, so
+ * they survive a crash of this process even before they are flushed.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps the file, replacing any file already mapped.
+     * @param randomAccess Hint that reads jump around the file, so read-ahead would be wasted.
+     * @return false if the file cannot be opened or mapped, or is empty.
+     */
+    bool open(const std::string& path, bool randomAccess = false);
+
+    /**
+     * @brief Maps an existing file for reading and writing, replacing any file already mapped.
+     * @return false if the file cannot be opened or mapped, or is empty.
+     */
+    bool openWritable(const std::string& path, bool randomAccess = false);
+    void close();
+
+    /**
+     * @brief Writes modified pages back to the file. Only waits for the disk if wait is set.
+     */
+    void flush(bool wait);
+
+    bool isOpen() const { return data_ != nullptr; }
+    const unsigned char* data() const { return data_; }
+
+    /// Null unless mapped with openWritable.
+    unsigned char* writableData() const { return writable_ ? data_ : nullptr; }
+    std::size_t size() const { return size_; }
+
+private:
+    bool map(const std::string& path, bool randomAccess, bool writable);
+
+    unsigned char* data_;
+    std::size_t size_;
+    bool writable_;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "chessTypes.h"
+
+enum class MoveFlag : std::uint16_t {
+    Normal = 0,
+    Promotion = 1,
+    EnPassant = 2,
+    Castling = 3
+};
+
+/**
+ * @brief A move packed into 16 bits.
+ *
+ * Bits 0-5 hold the origin square, bits 6-11 the destination square,
+ * bits 12-13 the promotion piece (knight..queen) and bits 14-15 the MoveFlag.
+ */
+class Move {
+public:
+    Move() : data_(0) {}
+
+    Move(int from, int to, MoveFlag flag = MoveFlag::Normal, PieceType promotion = PieceType::Knight)
+        : data_(static_cast<std::uint16_t>(from | (to << 6) |
+            ((static_cast<int>(promotion) - static_cast<int>(PieceType::Knight)) << 12) |
+            (static_cast<int>(flag) << 14))) {}
+
+    int from() const { return data_ & 0x3F; }
+    int to() const { return (data_ >> 6) & 0x3F; }
+    MoveFlag flag() const { return static_cast<MoveFlag>(data_ >> 14); }
+
+    PieceType promotion() const {
+        if (flag() != MoveFlag::Promotion) return PieceType::None;
+        return static_cast<PieceType>(static_cast<int>(PieceType::Knight) + ((data_ >> 12) & 3));
+    }
+
+    std::uint16_t raw() const { return data_; }
+
+    /**
+     * @brief Rebuilds a move from the value raw() returned, e.g. after storing it.
+     */
+    static Move fromRaw(std::uint16_t raw) {
+        Move move;
+        move.data_ = raw;
+        return move;
+    }
+
+    /**
+     * @brief The move in UCI long algebraic notation, e.g. "e2e4" or "e7e8q".
+     */
+    std::string toUci() const {
+        std::string uci = {
+            static_cast<char>('a' + (from() & 7)), static_cast<char>('1' + (from() >> 3)),
+            static_cast<char>('a' + (to() & 7)), static_cast<char>('1' + (to() >> 3))
+        };
+        if (flag() == MoveFlag::Promotion) {
+            uci += "nbrq"[static_cast<int>(promotion()) - static_cast<int>(PieceType::Knight)];
+        }
+        return uci;
+    }
+
+    bool isNone() const { return data_ == 0; }
+
+    bool operator==(const Move& other) const { return data_ == other.data_; }
+    bool operator!=(const Move& other) const { return data_ != other.data_; }
+
+private:
+    std::uint16_t data_;
+};
+
+/**
+ * @brief Fixed-capacity move list meant to live on the stack.
+ *
+ * 256 entries is above the 218 legal moves of the richest known position,
+ * so generation never needs to check for overflow or touch the heap.
+ */
+class MoveList {
+public:
+    static constexpr int Capacity = 256;
+
+    MoveList() : size_(0) {}
+
+    void push(Move move) { moves_[size_++] = move; }
+    void clear() { size_ = 0; }
+
+    int size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    Move operator[](int index) const { return moves_[index]; }
+
+    const Move* begin() const { return moves_; }
+    const Move* end() const { return moves_ + size_; }
+
+private:
+    Move moves_[Capacity];
+    int size_;
+};
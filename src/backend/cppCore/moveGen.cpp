@@ -0,0 +1,231 @@
+#include "moveGen.h"
+#include "attacks.h"
+
+using namespace Bitboards;
+
+namespace {
+    /**
+     * @brief Per-color constants resolved at compile time.
+     */
+    template<Color Us>
+    struct ColorTraits {
+        static constexpr Color Them = opposite(Us);
+        static constexpr Direction Up = Us == Color::White ? North : South;
+        static constexpr Direction UpEast = Us == Color::White ? NorthEast : SouthEast;
+        static constexpr Direction UpWest = Us == Color::White ? NorthWest : SouthWest;
+        static constexpr Bitboard DoublePushRank = Us == Color::White ? Rank1 << 16 : Rank1 << 40; ///< Rank reached by a single push from the start rank.
+        static constexpr Bitboard PromotionRank = Us == Color::White ? Rank8 : Rank1;
+        static constexpr int HomeKing = Us == Color::White ? 4 : 60;
+        static constexpr std::uint8_t Kingside = Us == Color::White ? WhiteKingside : BlackKingside;
+        static constexpr std::uint8_t Queenside = Us == Color::White ? WhiteQueenside : BlackQueenside;
+    };
+
+    // Removing both pawns from the rank can expose the king to a rook or queen,
+    // which no pin mask can catch, so en passant is checked against the final occupancy
+    template<Color Us>
+    bool isEnPassantLegal(const Position& pos, const MoveGen::CheckInfo& info, int from, int epSquare) {
+        if (info.kingSquare == NoSquare) return true;
+
+        constexpr Color Them = ColorTraits<Us>::Them;
+        int captured = epSquare - ColorTraits<Us>::Up;
+
+        if (info.checkers && !(info.checkMask & squareBit(epSquare)) && !(info.checkers & squareBit(captured))) {
+            return false;
+        }
+
+        Bitboard occupied = (pos.occupied() ^ squareBit(from) ^ squareBit(captured)) | squareBit(epSquare);
+        Bitboard rooks = pos.pieces(Them, PieceType::Rook) | pos.pieces(Them, PieceType::Queen);
+        Bitboard bishops = pos.pieces(Them, PieceType::Bishop) | pos.pieces(Them, PieceType::Queen);
+
+        return !(Attacks::rookAttacks(info.kingSquare, occupied) & rooks) &&
+            !(Attacks::bishopAttacks(info.kingSquare, occupied) & bishops);
+    }
+
+    // A pinned piece may only move along the line through its king
+    bool isPinLegal(const MoveGen::CheckInfo& info, int from, int to) {
+        return !(info.pinned & squareBit(from)) || (Attacks::line(info.kingSquare, from) & squareBit(to));
+    }
+
+    template<Direction D>
+    void addPawnMoves(const MoveGen::CheckInfo& info, Bitboard targets, Bitboard promotionRank, MoveList& moves) {
+        Bitboard promotions = targets & promotionRank;
+        targets &= ~promotionRank;
+
+        while (targets) {
+            int to = popLsb(targets);
+            if (isPinLegal(info, to - D, to)) {
+                moves.push(Move(to - D, to));
+            }
+        }
+
+        while (promotions) {
+            int to = popLsb(promotions);
+            if (isPinLegal(info, to - D, to)) {
+                moves.push(Move(to - D, to, MoveFlag::Promotion, PieceType::Queen));
+                moves.push(Move(to - D, to, MoveFlag::Promotion, PieceType::Rook));
+                moves.push(Move(to - D, to, MoveFlag::Promotion, PieceType::Bishop));
+                moves.push(Move(to - D, to, MoveFlag::Promotion, PieceType::Knight));
+            }
+        }
+    }
+
+    // Pawns move set-wise: every push and capture of one kind is a single shift of the pawn bitboard
+    template<Color Us>
+    void generatePawnMoves(const Position& pos, const MoveGen::CheckInfo& info, MoveList& moves) {
+        typedef ColorTraits<Us> Traits;
+
+        Bitboard pawns = pos.pieces(Us, PieceType::Pawn);
+        Bitboard empty = ~pos.occupied();
+        Bitboard enemies = pos.pieces(Traits::Them);
+
+        Bitboard singlePushes = shift<Traits::Up>(pawns) & empty;
+        Bitboard doublePushes = shift<Traits::Up>(singlePushes & Traits::DoublePushRank) & empty;
+
+        addPawnMoves<Traits::Up>(info, singlePushes & info.checkMask, Traits::PromotionRank, moves);
+        addPawnMoves<Traits::UpEast>(info, shift<Traits::UpEast>(pawns) & enemies & info.checkMask, Traits::PromotionRank, moves);
+        addPawnMoves<Traits::UpWest>(info, shift<Traits::UpWest>(pawns) & enemies & info.checkMask, Traits::PromotionRank, moves);
+        addPawnMoves<static_cast<Direction>(2 * Traits::Up)>(info, doublePushes & info.checkMask, 0, moves);
+
+        // En passant belongs to the side to move only
+        int epSquare = pos.enPassantSquare();
+        if (epSquare == NoSquare || Us != pos.sideToMove()) return;
+
+        Bitboard capturers = Attacks::pawnAttacks(Traits::Them, epSquare) & pawns;
+        while (capturers) {
+            int from = popLsb(capturers);
+            if (isEnPassantLegal<Us>(pos, info, from, epSquare)) {
+                moves.push(Move(from, epSquare, MoveFlag::EnPassant));
+            }
+        }
+    }
+
+    template<PieceType Pt>
+    void generatePieceMoves(const Position& pos, const MoveGen::CheckInfo& info, Bitboard pieces, MoveList& moves) {
+        // A pinned knight can never stay on its pin line
+        if (Pt == PieceType::Knight) pieces &= ~info.pinned;
+
+        Bitboard occupied = pos.occupied();
+        Bitboard allowed = ~pos.pieces(info.us) & info.checkMask;
+        while (pieces) {
+            int from = popLsb(pieces);
+            Bitboard targets = Attacks::attacksFrom<Pt>(from, occupied) & allowed;
+            if (info.pinned & squareBit(from)) {
+                targets &= Attacks::line(info.kingSquare, from);
+            }
+            while (targets) {
+                moves.push(Move(from, popLsb(targets)));
+            }
+        }
+    }
+
+    template<Color Us>
+    void generateKingMoves(const Position& pos, const MoveGen::CheckInfo& info, MoveList& moves) {
+        typedef ColorTraits<Us> Traits;
+        int from = info.kingSquare;
+        Bitboard candidates = Attacks::kingAttacks(from) & ~pos.pieces(Us);
+
+        // Take the king off the board so it cannot hide behind itself on a slider's ray
+        Bitboard occupied = pos.occupied() ^ squareBit(from);
+        while (candidates) {
+            int to = popLsb(candidates);
+            if (!(pos.attackersTo(to, occupied) & pos.pieces(Traits::Them))) {
+                moves.push(Move(from, to));
+            }
+        }
+
+        // Castling: not out of, through or into check, and with an empty path to the rook
+        std::uint8_t rights = pos.castlingRights();
+        if (from != Traits::HomeKing || info.checkers || !(rights & (Traits::Kingside | Traits::Queenside))) return;
+
+        occupied = pos.occupied();
+        if ((rights & Traits::Kingside) && !(occupied & (squareBit(from + 1) | squareBit(from + 2))) &&
+            !pos.isSquareAttacked(from + 1, Traits::Them) && !pos.isSquareAttacked(from + 2, Traits::Them)) {
+            moves.push(Move(from, from + 2, MoveFlag::Castling));
+        }
+
+        // On the queenside the b-file square only has to be empty
+        if ((rights & Traits::Queenside) && !(occupied & (squareBit(from - 1) | squareBit(from - 2) | squareBit(from - 3))) &&
+            !pos.isSquareAttacked(from - 1, Traits::Them) && !pos.isSquareAttacked(from - 2, Traits::Them)) {
+            moves.push(Move(from, from - 2, MoveFlag::Castling));
+        }
+    }
+
+    template<Color Us>
+    void generateLegalMoves(const Position& pos, const MoveGen::CheckInfo& info, MoveList& moves) {
+        if (info.kingSquare != NoSquare) {
+            generateKingMoves<Us>(pos, info, moves);
+        }
+
+        if (moreThanOne(info.checkers)) return;
+
+        generatePawnMoves<Us>(pos, info, moves);
+        generatePieceMoves<PieceType::Knight>(pos, info, pos.pieces(Us, PieceType::Knight), moves);
+        generatePieceMoves<PieceType::Bishop>(pos, info, pos.pieces(Us, PieceType::Bishop), moves);
+        generatePieceMoves<PieceType::Rook>(pos, info, pos.pieces(Us, PieceType::Rook), moves);
+        generatePieceMoves<PieceType::Queen>(pos, info, pos.pieces(Us, PieceType::Queen), moves);
+    }
+}
+
+namespace MoveGen {
+
+    CheckInfo computeCheckInfo(const Position& pos, Color us) {
+        CheckInfo info;
+        Color them = opposite(us);
+        info.us = us;
+        info.kingSquare = pos.kingSquare(us);
+        info.checkers = 0;
+        info.checkMask = ~Bitboard(0);
+        info.pinned = 0;
+
+        if (info.kingSquare == NoSquare) return info;
+
+        Bitboard occupied = pos.occupied();
+        info.checkers = pos.attackersTo(info.kingSquare, occupied) & pos.pieces(them);
+
+        if (info.checkers) {
+            // Double check leaves only king moves; a single check may be blocked or captured
+            info.checkMask = moreThanOne(info.checkers) ? 0 : Attacks::between(info.kingSquare, lsb(info.checkers));
+        }
+
+        // Enemy sliders that would hit the king on an empty board are pinning if exactly one of our pieces is in between
+        Bitboard snipers =
+            (Attacks::rookAttacks(info.kingSquare, 0) & (pos.pieces(them, PieceType::Rook) | pos.pieces(them, PieceType::Queen))) |
+            (Attacks::bishopAttacks(info.kingSquare, 0) & (pos.pieces(them, PieceType::Bishop) | pos.pieces(them, PieceType::Queen)));
+
+        while (snipers) {
+            int sniper = popLsb(snipers);
+            Bitboard blockers = Attacks::between(info.kingSquare, sniper) & ~squareBit(sniper) & occupied;
+            if (blockers && !moreThanOne(blockers)) {
+                info.pinned |= blockers & pos.pieces(us);
+            }
+        }
+
+        return info;
+    }
+
+    void generateLegalMoves(const Position& pos, const CheckInfo& info, MoveList& moves) {
+        // The only runtime color dispatch; everything below is specialized per color
+        if (info.us == Color::White) {
+            ::generateLegalMoves<Color::White>(pos, info, moves);
+        }
+        else {
+            ::generateLegalMoves<Color::Black>(pos, info, moves);
+        }
+    }
+
+    void generateLegalMoves(const Position& pos, Color us, MoveList& moves) {
+        generateLegalMoves(pos, computeCheckInfo(pos, us), moves);
+    }
+
+    bool findLegalMove(const Position& pos, int from, int to, PieceType promotion, Move& move) {
+        MoveList moves;
+        generateLegalMoves(pos, pos.sideToMove(), moves);
+        for (Move candidate : moves) {
+            if (candidate.from() == from && candidate.to() == to && candidate.promotion() == promotion) {
+                move = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "position.h"
+#include "move.h"
+
+/**
+ * @brief Fully legal move generation without trial moves.
+ *
+ * Checkers, pinned pieces and the check-evasion mask are computed once per
+ * position and color; every generated move is legal by construction, so the
+ * position is never modified and concurrent readers are safe.
+ */
+namespace MoveGen {
+
+    struct CheckInfo {
+        Color us;
+        int kingSquare;
+        Bitboard checkers;   ///< Enemy pieces giving check.
+        Bitboard checkMask;  ///< Squares a non-king move must land on (all squares when not in check).
+        Bitboard pinned;     ///< Our pieces pinned to our king.
+    };
+
+    /**
+     * @brief Computes check and pin information for the given color.
+     */
+    CheckInfo computeCheckInfo(const Position& pos, Color us);
+
+    /**
+     * @brief Appends every legal move of the given color.
+     *
+     * Works for either color; en passant is only generated for the side to move.
+     * Promotions are emitted once per promotion piece.
+     */
+    void generateLegalMoves(const Position& pos, const CheckInfo& info, MoveList& moves);
+    void generateLegalMoves(const Position& pos, Color us, MoveList& moves);
+
+    /**
+     * @brief Finds the legal move of the side to move with the given squares and promotion piece.
+     *
+     * For moves decoded from text or books, which carry no castling or en passant flag.
+     * @param promotion PieceType::None unless the move promotes.
+     * @return false if no such move is legal.
+     */
+    bool findLegalMove(const Position& pos, int from, int to, PieceType promotion, Move& move);
+}
@@ -0,0 +1,111 @@
+#include "openingBook.h"
+#include "polyglot.h"
+#include "moveGen.h"
+#include <random>
+
+namespace {
+    std::uint64_t readBigEndian(const unsigned char* bytes, int length) {
+        std::uint64_t value = 0;
+        for (int i = 0; i < length; i++) {
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+
+    /// More candidates than any position has legal moves, so none is ever dropped.
+    const int MaxCandidates = 256;
+}
+
+bool OpeningBook::open(const Settings& settings) {
+    // Binary search jumps around the file, so read-ahead would only waste I/O
+    if (!file_.open(settings.path, true)) return false;
+    if (size() == 0) {
+        file_.close();
+        return false;
+    }
+    settings_ = settings;
+    return true;
+}
+
+void OpeningBook::close() {
+    file_.close();
+}
+
+std::uint64_t OpeningBook::keyAt(std::size_t index) const {
+    return readBigEndian(file_.data() + index * EntrySize, 8);
+}
+
+bool OpeningBook::probe(const Position& position, int ply, Move& move) const {
+    if (!isOpen()) return false;
+    if (settings_.maxPly > 0 && ply >= settings_.maxPly) return false;
+
+    // First entry with the position's key
+    std::uint64_t key = Polyglot::key(position);
+    std::size_t low = 0;
+    std::size_t entries = size();
+    std::size_t high = entries;
+    while (low < high) {
+        std::size_t middle = low + (high - low) / 2;
+        if (keyAt(middle) < key) low = middle + 1;
+        else high = middle;
+    }
+
+    Move candidates[MaxCandidates];
+    unsigned weights[MaxCandidates];
+    int count = 0;
+    unsigned bestWeight = 0;
+    for (std::size_t index = low; index < entries && keyAt(index) == key && count < MaxCandidates; index++) {
+        const unsigned char* entry = file_.data() + index * EntrySize;
+        unsigned weight = static_cast<unsigned>(readBigEndian(entry + 10, 2));
+
+        // Weight 0 marks a move the book author wants known but never played
+        Move candidate;
+        if (weight == 0 || !decodeMove(position, static_cast<std::uint16_t>(readBigEndian(entry + 8, 2)), candidate)) continue;
+
+        candidates[count] = candidate;
+        weights[count] = weight;
+        count++;
+        if (weight > bestWeight) bestWeight = weight;
+    }
+    if (count == 0) return false;
+
+    // Variety lowers the bar from the best weight towards zero; survivors are drawn in proportion to weight
+    int variety = settings_.variety < 0 ? 0 : (settings_.variety > 100 ? 100 : settings_.variety);
+    unsigned threshold = static_cast<unsigned>(static_cast<std::uint64_t>(bestWeight) * static_cast<unsigned>(100 - variety) / 100);
+    std::uint64_t total = 0;
+    for (int i = 0; i < count; i++) {
+        if (weights[i] >= threshold) total += weights[i];
+    }
+
+    thread_local std::mt19937_64 random{ std::random_device{}() };
+    std::uint64_t pick = variety == 0 ? 0 : std::uniform_int_distribution<std::uint64_t>(0, total - 1)(random);
+    for (int i = 0; i < count; i++) {
+        if (weights[i] < threshold) continue;
+        if (pick < weights[i]) {
+            move = candidates[i];
+            return true;
+        }
+        pick -= weights[i];
+    }
+    return false;
+}
+
+bool OpeningBook::decodeMove(const Position& position, std::uint16_t raw, Move& move) {
+    // Bits 0-5 hold the destination and 6-11 the origin, both a1 = 0 like our squares
+    int to = raw & 0x3F;
+    int from = (raw >> 6) & 0x3F;
+    int promotion = (raw >> 12) & 7;
+
+    if (position.pieceTypeAt(from) == PieceType::King) {
+        // e1h1 is short castling, e1a1 long, and likewise on the eighth rank
+        if ((from == 4 && to == 7) || (from == 60 && to == 63)) to = from + 2;
+        else if ((from == 4 && to == 0) || (from == 60 && to == 56)) to = from - 2;
+    }
+
+    // 1-4 are knight to queen, in our PieceType order
+    PieceType promotionType = promotion == 0 ? PieceType::None
+        : static_cast<PieceType>(static_cast<int>(PieceType::Knight) + promotion - 1);
+
+    // Also guards against a corrupt book or a key collision
+    return MoveGen::findLegalMove(position, from, to, promotionType, move);
+}
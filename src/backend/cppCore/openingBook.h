@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "mappedFile.h"
+#include "position.h"
+
+/**
+ * @brief Read-only Polyglot (.bin) opening book.
+ *
+ * The file is memory-mapped rather than loaded, so opening even a large book is
+ * instant and only the pages a lookup touches are ever read. Entries are sorted
+ * by Polyglot key, so a probe is a binary search. Probing never modifies the
+ * book and is safe from any number of threads.
+ */
+class OpeningBook {
+public:
+    struct Settings {
+        std::string path;       ///< Polyglot .bin file; empty for no book.
+        int maxPly = 16;        ///< The book is only used for this many plies from the start of a game; 0 for no limit.
+        int variety = 0;        ///< 0 always plays the most weighted move, 100 picks in proportion to weight.
+    };
+
+    /**
+     * @brief Maps the book file, replacing any book already open.
+     * @return false if the file cannot be opened or mapped.
+     */
+    bool open(const Settings& settings);
+    void close();
+
+    bool isOpen() const { return file_.isOpen(); }
+
+    /// Number of entries in the book.
+    std::size_t size() const { return file_.size() / EntrySize; }
+
+    /**
+     * @brief Chooses a book move for the position among its weighted entries.
+     * @param ply Plies played since the start of the game.
+     * @return false if the book is closed, ply is past the book depth, or no legal entry matches.
+     */
+    bool probe(const Position& position, int ply, Move& move) const;
+
+private:
+    /// Entries are 16 big-endian bytes: key, move, weight and a learn field we ignore.
+    static constexpr std::size_t EntrySize = 16;
+
+    std::uint64_t keyAt(std::size_t index) const;
+
+    /**
+     * @brief Decodes a Polyglot move, which gives castling as the king taking its own rook.
+     */
+    static bool decodeMove(const Position& position, std::uint16_t raw, Move& move);
+
+    MappedFile file_;
+    Settings settings_;
+};
@@ -0,0 +1,257 @@
+#include "chessValidator.h"
+#include "moveGen.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Perft benchmark and move generator regression gate.
+ *
+ * Usage:
+ *   perft --suite [--depth N] [--threads N] [--hash MB]
+ *   perft [--fen "<fen>"] --depth N [--divide] [--threads N] [--hash MB]
+ *
+ * --suite checks the standard reference positions against their known node
+ * counts and exits non-zero on any mismatch.
+ */
+
+namespace {
+    const char* StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    struct ReferencePosition {
+        const char* name;
+        const char* fen;
+        std::uint64_t nodes[6]; ///< Expected counts for depths 1 to 6.
+    };
+
+    const ReferencePosition ReferencePositions[] = {
+        { "startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            { 20, 400, 8902, 197281, 4865609, 119060324 } },
+        { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            { 48, 2039, 97862, 4085603, 193690690, 8031647685ULL } },
+        { "position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            { 14, 191, 2812, 43238, 674624, 11030083 } },
+        { "position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            { 6, 264, 9467, 422333, 15833292, 706045033 } },
+        { "position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+            { 44, 1486, 62379, 2103487, 89941194, 3048196529ULL } },
+        { "position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+            { 46, 2079, 89890, 3894594, 164075551, 6923051137ULL } },
+    };
+
+    /**
+     * Shared perft transposition table. Entries are stored as (key ^ data, data)
+     * so a torn write from another thread fails verification instead of
+     * returning a wrong count, which keeps the table lock-free.
+     */
+    class PerftTable {
+    public:
+        explicit PerftTable(std::size_t megabytes) {
+            std::size_t count = 1;
+            while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024) count *= 2;
+            entries_.reset(new Entry[count]);
+            mask_ = count - 1;
+            for (std::size_t i = 0; i < count; i++) {
+                entries_[i].check.store(0, std::memory_order_relaxed);
+                entries_[i].data.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        bool probe(std::uint64_t key, int depth, std::uint64_t& nodes) const {
+            const Entry& entry = entries_[key & mask_];
+            std::uint64_t data = entry.data.load(std::memory_order_relaxed);
+            std::uint64_t check = entry.check.load(std::memory_order_relaxed);
+            if ((check ^ data) != key || static_cast<int>(data & 0xFF) != depth) return false;
+            nodes = data >> 8;
+            return true;
+        }
+
+        void store(std::uint64_t key, int depth, std::uint64_t nodes) {
+            Entry& entry = entries_[key & mask_];
+            std::uint64_t data = (nodes << 8) | static_cast<std::uint64_t>(depth);
+            entry.check.store(key ^ data, std::memory_order_relaxed);
+            entry.data.store(data, std::memory_order_relaxed);
+        }
+
+    private:
+        struct Entry {
+            std::atomic<std::uint64_t> check;
+            std::atomic<std::uint64_t> data;
+        };
+
+        std::unique_ptr<Entry[]> entries_;
+        std::size_t mask_;
+    };
+
+    std::uint64_t perft(Position& pos, int depth, PerftTable* table) {
+        MoveList moves;
+        MoveGen::generateLegalMoves(pos, pos.sideToMove(), moves);
+
+        // Bulk counting: the last ply only needs the number of legal moves
+        if (depth <= 1) return depth == 1 ? moves.size() : 1;
+
+        std::uint64_t key = 0;
+        std::uint64_t nodes = 0;
+        if (table) {
+            key = pos.key();
+            if (table->probe(key, depth, nodes)) return nodes;
+        }
+
+        for (Move move : moves) {
+            UndoInfo undo;
+            pos.doMove(move, undo);
+            nodes += perft(pos, depth - 1, table);
+            pos.undoMove(move, undo);
+        }
+
+        if (table) table->store(key, depth, nodes);
+        return nodes;
+    }
+
+    struct DivideResult {
+        Move move;
+        std::uint64_t nodes;
+    };
+
+    std::uint64_t divide(const Position& root, int depth, int threadCount, PerftTable* table, std::vector<DivideResult>& results) {
+        MoveList moves;
+        MoveGen::generateLegalMoves(root, root.sideToMove(), moves);
+
+        results.clear();
+        for (Move move : moves) results.push_back({ move, 0 });
+        if (depth <= 0) return 1;
+
+        // Root moves are handed out one at a time so uneven subtrees balance across threads
+        std::atomic<int> nextMove(0);
+        auto worker = [&]() {
+            // Each thread walks its subtrees with make/unmake on a private copy
+            Position pos = root;
+            for (int i = nextMove++; i < static_cast<int>(results.size()); i = nextMove++) {
+                UndoInfo undo;
+                pos.doMove(results[i].move, undo);
+                results[i].nodes = perft(pos, depth - 1, table);
+                pos.undoMove(results[i].move, undo);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int i = 1; i < threadCount; i++) threads.emplace_back(worker);
+        worker();
+        for (auto& thread : threads) thread.join();
+
+        std::uint64_t total = 0;
+        for (const auto& result : results) total += result.nodes;
+        return total;
+    }
+
+    struct Options {
+        std::string fen = StartFen;
+        int depth = 5;
+        int threads = 1;
+        std::size_t hashMegabytes = 0;
+        bool divide = false;
+        bool suite = false;
+    };
+
+    bool parseOptions(int argc, char* argv[], Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (arg == "--suite") options.suite = true;
+            else if (arg == "--divide") options.divide = true;
+            else if (arg == "--fen" && hasValue) options.fen = argv[++i];
+            else if (arg == "--depth" && hasValue) options.depth = std::atoi(argv[++i]);
+            else if (arg == "--threads" && hasValue) options.threads = std::atoi(argv[++i]);
+            else if (arg == "--hash" && hasValue) options.hashMegabytes = static_cast<std::size_t>(std::atoi(argv[++i]));
+            else return false;
+        }
+        return options.depth >= 0 && options.threads >= 1;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void printRate(std::uint64_t nodes, double seconds) {
+        std::cout << nodes << " nodes in " << std::fixed << std::setprecision(3) << seconds << "s ("
+            << static_cast<std::uint64_t>(seconds > 0 ? nodes / seconds : 0) << " nps)" << std::endl;
+    }
+
+    int runSuite(const Options& options, PerftTable* table) {
+        int depth = options.depth < 1 ? 1 : (options.depth > 6 ? 6 : options.depth);
+        int failures = 0;
+        std::uint64_t totalNodes = 0;
+        auto suiteStart = std::chrono::steady_clock::now();
+
+        for (const auto& reference : ReferencePositions) {
+            ChessValidator validator;
+            validator.setBoardFromFen(reference.fen);
+
+            std::vector<DivideResult> results;
+            auto start = std::chrono::steady_clock::now();
+            std::uint64_t nodes = divide(validator.getPosition(), depth, options.threads, table, results);
+            double seconds = secondsSince(start);
+            std::uint64_t expected = reference.nodes[depth - 1];
+
+            bool ok = nodes == expected;
+            if (!ok) failures++;
+            totalNodes += nodes;
+
+            std::cout << (ok ? "[ OK ] " : "[FAIL] ") << std::left << std::setw(10) << reference.name
+                << " depth " << depth << ": ";
+            if (!ok) std::cout << "expected " << expected << ", got ";
+            printRate(nodes, seconds);
+        }
+
+        std::cout << "total: ";
+        printRate(totalNodes, secondsSince(suiteStart));
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: perft [--suite] [--fen <fen>] [--depth N] [--divide] [--threads N] [--hash MB]" << std::endl;
+        return 2;
+    }
+
+    std::unique_ptr<PerftTable> table;
+    if (options.hashMegabytes > 0) {
+        table.reset(new PerftTable(options.hashMegabytes));
+    }
+
+    if (options.suite) {
+        return runSuite(options, table.get());
+    }
+
+    ChessValidator validator;
+    Fen::Error error;
+    if (!validator.setBoardFromFen(options.fen, &error)) {
+        std::cerr << "invalid FEN (" << Fen::errorMessage(error) << "): " << options.fen << std::endl;
+        return 2;
+    }
+
+    std::vector<DivideResult> results;
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t nodes = divide(validator.getPosition(), options.depth, options.threads, table.get(), results);
+    double seconds = secondsSince(start);
+
+    if (options.divide) {
+        for (const auto& result : results) {
+            std::cout << result.move.toUci() << ": " << result.nodes << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    printRate(nodes, seconds);
+    return 0;
+}
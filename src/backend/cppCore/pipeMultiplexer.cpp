@@ -0,0 +1,80 @@
+#include "pipeMultiplexer.h"
+
+#ifndef _WIN32
+
+#include "childProcess.h"
+#include <cerrno>
+#include <thread>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+PipeMultiplexer& PipeMultiplexer::instance() {
+    // Deliberately never destroyed: engines held by other statics may still
+    // unregister from it during exit
+    static PipeMultiplexer* multiplexer = new PipeMultiplexer();
+    return *multiplexer;
+}
+
+PipeMultiplexer::PipeMultiplexer()
+    : epollFd_(epoll_create1(EPOLL_CLOEXEC)) {
+    std::thread(&PipeMultiplexer::run, this).detach();
+}
+
+bool PipeMultiplexer::add(int fd, ChildProcess* process) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) return false;
+
+    readers_[fd] = process;
+    return true;
+}
+
+void PipeMultiplexer::remove(int fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (readers_.erase(fd)) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+void PipeMultiplexer::run() {
+    epoll_event events[64];
+    static char chunk[64 * 1024];
+
+    for (;;) {
+        int ready = epoll_wait(epollFd_, events, 64, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            int fd = events[i].data.fd;
+
+            // The fd may have been removed after epoll_wait returned; the map is the authority
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = readers_.find(fd);
+            if (it == readers_.end()) continue;
+
+            for (;;) {
+                ssize_t length = read(fd, chunk, sizeof(chunk));
+                if (length > 0) {
+                    it->second->onOutput(chunk, static_cast<std::size_t>(length));
+                    continue;
+                }
+                if (length < 0 && errno == EINTR) continue;
+                if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+                // End of file or a hard error: the child is gone
+                epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+                it->second->onClosed();
+                readers_.erase(it);
+                break;
+            }
+        }
+    }
+}
+
+#endif
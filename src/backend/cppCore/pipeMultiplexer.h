@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <mutex>
+#include <unordered_map>
+
+class ChildProcess;
+
+/**
+ * @brief One epoll thread that drains the stdout pipes of every child process.
+ *
+ * Child output is handed to its ChildProcess as it arrives, so no thread is
+ * left blocked in read() on any single pipe.
+ */
+class PipeMultiplexer {
+public:
+    /**
+     * @brief The process-wide multiplexer, started on first use.
+     */
+    static PipeMultiplexer& instance();
+
+    /**
+     * @brief Starts delivering output from the non-blocking fd to process.
+     */
+    bool add(int fd, ChildProcess* process);
+
+    /**
+     * @brief Stops delivering output from fd. Once this returns the event
+     * thread no longer touches the process, so the fd may be closed.
+     */
+    void remove(int fd);
+
+private:
+    PipeMultiplexer();
+    void run();
+
+    int epollFd_;
+    std::mutex mutex_;      ///< Held while a pipe is being drained.
+    std::unordered_map<int, ChildProcess*> readers_;
+};
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include "position.h"
+
+/**
+ * @brief Polyglot opening book hashing.
+ *
+ * Polyglot books are keyed by their own hash rather than our Zobrist keys: the
+ * XOR of one Random64 entry per (piece, square), one per castling right, one for
+ * the en passant file when a capture is possible and one when White is to move.
+ */
+namespace Polyglot {
+
+    /// The published Polyglot table: 768 piece keys, then 4 castling, 8 en passant and 1 side-to-move key.
+    extern const std::uint64_t Random64[781];
+
+    /**
+     * @brief The Polyglot key of a position, as stored in .bin book entries.
+     */
+    std::uint64_t key(const Position& position);
+}
@@ -0,0 +1,82 @@
+#include "polyglot.h"
+#include "fen.h"
+#include "moveGen.h"
+#include "uci.h"
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/**
+ * Polyglot hashing regression gate.
+ *
+ * Usage:
+ *   polyglotTest
+ *
+ * Checks every test key of the Polyglot book format specification, both for the
+ * position parsed from its FEN and for the one reached by playing its moves from
+ * the start, and exits non-zero on any mismatch.
+ */
+
+namespace {
+    const char* StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    struct ReferenceKey {
+        const char* moves;
+        const char* fen;
+        std::uint64_t key;
+    };
+
+    const ReferenceKey ReferenceKeys[] = {
+        { "", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463B96181691FC9CULL },
+        { "e2e4", "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823C9B50FD114196ULL },
+        { "e2e4 d7d5", "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756B94461C50FB0ULL },
+        { "e2e4 d7d5 e4e5", "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662FAFB965DB29D4ULL },
+        { "e2e4 d7d5 e4e5 f7f5", "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22A48B5A8E47FF78ULL },
+        { "e2e4 d7d5 e4e5 f7f5 e1e2", "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652A607CA3F242C1ULL },
+        { "e2e4 d7d5 e4e5 f7f5 e1e2 e8f7", "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00FDD303C946BDD9ULL },
+        { "a2a4 b7b5 h2h4 b5b4 c2c4", "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3C8123EA7B067637ULL },
+        { "a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a2", "rnbqkbnr/p1pppppp/8/8/P6P/2p5/RP1PPPP1/1NBQKBNR b Kkq - 1 4", 0x5C3F9B829B279560ULL },
+    };
+
+    bool playMoves(Position& position, const std::string& moves) {
+        std::istringstream iss(moves);
+        std::string text;
+        while (iss >> text) {
+            Move uciMove;
+            Move move;
+            if (!Uci::parseMove(text, uciMove) ||
+                !MoveGen::findLegalMove(position, uciMove.from(), uciMove.to(), uciMove.promotion(), move)) {
+                return false;
+            }
+            position.doMove(move);
+        }
+        return true;
+    }
+
+    std::string hex(std::uint64_t key) {
+        std::ostringstream oss;
+        oss << std::hex << std::setw(16) << std::setfill('0') << key;
+        return oss.str();
+    }
+}
+
+int main() {
+    int failures = 0;
+    for (const auto& reference : ReferenceKeys) {
+        Position fromFen;
+        Position played;
+        int fullmoveNumber;
+        bool parsed = Fen::parse(reference.fen, fromFen, fullmoveNumber) == Fen::Error::None &&
+            Fen::parse(StartFen, played, fullmoveNumber) == Fen::Error::None && playMoves(played, reference.moves);
+        std::uint64_t fenKey = parsed ? Polyglot::key(fromFen) : 0;
+        std::uint64_t playedKey = parsed ? Polyglot::key(played) : 0;
+
+        bool ok = parsed && fenKey == reference.key && playedKey == reference.key;
+        if (!ok) failures++;
+        std::cout << (ok ? "[ OK ] " : "[FAIL] ") << (*reference.moves ? reference.moves : "startpos")
+            << ": " << hex(fenKey) << " / " << hex(playedKey) << " (expected " << hex(reference.key) << ")" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
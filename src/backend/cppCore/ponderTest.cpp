@@ -0,0 +1,171 @@
+#include "stockfishHandler.h"
+#include "fen.h"
+#include "moveGen.h"
+#include "position.h"
+#include "uci.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/**
+ * Pondering regression tests, run through StockfishApiHandler against the fake engine.
+ *
+ * Usage:
+ *   ponderTest [--engine <path>]
+ *
+ * The engine defaults to ./fakeEngine.py, which runs as is wherever scripts with a
+ * "#!" line can be executed; elsewhere pass an executable that runs it. Every game
+ * starts after 1. e4 with the engine answering 1... e5 and predicting 2. Nf3.
+ * Covers a ponderhit when the game plays the engine's move and then the predicted
+ * reply, with or without a search in between and whether or not that search
+ * ponders itself, and the ponder being dropped when the game leaves that line.
+ * Exits non-zero if any check fails.
+ */
+
+namespace {
+    const char* StartFen = "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1";
+
+    struct Options {
+        std::string engine = "./fakeEngine.py";
+    };
+
+    bool parseOptions(int argc, char* argv[], Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) return false;
+            if (arg == "--engine") options.engine = argv[++i];
+            else return false;
+        }
+        return true;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * @brief A position of a test game, reached by playing UCI moves from StartFen.
+     */
+    struct Line {
+        std::string fen;            ///< Empty if a move was not legal.
+        std::uint64_t key = 0;
+    };
+
+    Line afterMoves(const std::string& moves) {
+        Line line;
+        Position position;
+        int fullmoveNumber;
+        if (Fen::parse(StartFen, position, fullmoveNumber) != Fen::Error::None) return line;
+
+        std::istringstream iss(moves);
+        std::string text;
+        while (iss >> text) {
+            Move uciMove;
+            Move move;
+            if (!Uci::parseMove(text, uciMove) ||
+                !MoveGen::findLegalMove(position, uciMove.from(), uciMove.to(), uciMove.promotion(), move)) {
+                return line;
+            }
+            if (position.sideToMove() == Color::Black) fullmoveNumber++;
+            position.doMove(move);
+        }
+
+        char buffer[Fen::MaxLength];
+        line.fen.assign(buffer, Fen::write(position, fullmoveNumber, buffer));
+        line.key = position.key();
+        return line;
+    }
+
+    /**
+     * @brief Searches a position of the game as a client playing against the engine would, pondering afterwards if asked.
+     */
+    bool searchAt(const Options& options, const std::string& gameId, const std::string& moves, SearchResult& result, bool ponder = true) {
+        Line line = afterMoves(moves);
+        if (line.fen.empty()) return false;
+
+        SearchLimits limits;
+        limits.movetimeMs = 50;
+        limits.deadlineMs = 5000;
+        limits.ponder = ponder;
+        return StockfishApiHandler::search(options.engine, line.fen, limits, gameId, result);
+    }
+
+    bool testHitAfterEverySearch(const Options& options) {
+        // A hot-seat client asks for a move after each ply; the search on the engine's own move leaves the ponder running
+        SearchResult first, own, reply;
+        return searchAt(options, "every-ply", "", first) && first.bestmove == "e7e5" && first.ponder == "g1f3" && !first.ponderhit
+            && searchAt(options, "every-ply", "e7e5", own) && !own.ponderhit
+            && searchAt(options, "every-ply", "e7e5 g1f3", reply) && reply.ponderhit;
+    }
+
+    bool testHitAfterPlayedMove(const Options& options) {
+        // The engine's move is played back without a search, as /validate-move does without getStockfishMove
+        SearchResult first, reply;
+        if (!searchAt(options, "played-move", "", first)) return false;
+        StockfishApiHandler::followPondering("played-move", afterMoves("e7e5").key);
+        return searchAt(options, "played-move", "e7e5 g1f3", reply) && reply.ponderhit;
+    }
+
+    bool testHitWithoutPondering(const Options& options) {
+        // Like /validate-move, whose searches only ponder on request: the predicted reply still takes the ponder over
+        SearchResult first, own, reply;
+        return searchAt(options, "no-ponder-flag", "", first)
+            && searchAt(options, "no-ponder-flag", "e7e5", own, false) && !own.ponderhit
+            && searchAt(options, "no-ponder-flag", "e7e5 g1f3", reply, false) && reply.ponderhit;
+    }
+
+    bool testMissedReply(const Options& options) {
+        SearchResult first, own, reply;
+        return searchAt(options, "missed-reply", "", first) && searchAt(options, "missed-reply", "e7e5", own)
+            && searchAt(options, "missed-reply", "e7e5 b1c3", reply) && !reply.ponderhit;
+    }
+
+    bool testOtherMove(const Options& options) {
+        // Once the game leaves the line, reaching the pondered position later is no hit
+        SearchResult first, reply;
+        if (!searchAt(options, "other-move", "", first)) return false;
+        StockfishApiHandler::followPondering("other-move", afterMoves("d7d5").key);
+        return searchAt(options, "other-move", "e7e5 g1f3", reply) && !reply.ponderhit;
+    }
+
+    struct Test {
+        const char* name;
+        bool (*run)(const Options& options);
+    };
+
+    const Test Tests[] = {
+        { "ponderhit after a search on every ply", testHitAfterEverySearch },
+        { "ponderhit after the engine's move is played", testHitAfterPlayedMove },
+        { "ponderhit for a search that does not ponder", testHitWithoutPondering },
+        { "no ponderhit on another reply", testMissedReply },
+        { "no ponderhit after leaving the line", testOtherMove },
+    };
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: ponderTest [--engine <path>]" << std::endl;
+        return 2;
+    }
+
+    // A ponder holds one engine while the game's other searches run on the second
+#ifdef _WIN32
+    _putenv_s("FAKE_ENGINE_BESTMOVE", "e7e5 g1f3");
+#else
+    setenv("FAKE_ENGINE_BESTMOVE", "e7e5 g1f3", 1);
+#endif
+    StockfishApiHandler::setEngineCount(2);
+
+    int failures = 0;
+    for (const auto& test : Tests) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = test.run(options);
+        if (!ok) failures++;
+        std::cout << (ok ? "[ OK ] " : "[FAIL] ") << test.name << " (" << secondsSince(start) << " s)" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,248 @@
+#include "position.h"
+#include "attacks.h"
+#include "zobrist.h"
+#include <cstdlib>
+
+using namespace Bitboards;
+
+namespace {
+    // Castling rights lost when a piece moves from or to the square
+    std::uint8_t castlingRightsLostOn(int square) {
+        switch (square) {
+        case 0: return WhiteQueenside;
+        case 4: return WhiteKingside | WhiteQueenside;
+        case 7: return WhiteKingside;
+        case 56: return BlackQueenside;
+        case 60: return BlackKingside | BlackQueenside;
+        case 63: return BlackKingside;
+        default: return 0;
+        }
+    }
+}
+
+Position::Position() {
+    clear();
+}
+
+void Position::clear() {
+    for (auto& bb : byType_) bb = 0;
+    for (auto& bb : byColor_) bb = 0;
+    for (auto& sq : board_) sq = EmptySquare;
+    sideToMove_ = Color::White;
+    castlingRights_ = 0;
+    epSquare_ = NoSquare;
+    halfmoveClock_ = 0;
+    key_ = 0;
+    materialKey_ = 0;
+}
+
+void Position::setStartPosition() {
+    clear();
+
+    const PieceType backRank[8] = {
+        PieceType::Rook, PieceType::Knight, PieceType::Bishop, PieceType::Queen,
+        PieceType::King, PieceType::Bishop, PieceType::Knight, PieceType::Rook
+    };
+
+    for (int file = 0; file < 8; file++) {
+        putPiece(Color::White, backRank[file], makeSquare(file, 0));
+        putPiece(Color::White, PieceType::Pawn, makeSquare(file, 1));
+        putPiece(Color::Black, PieceType::Pawn, makeSquare(file, 6));
+        putPiece(Color::Black, backRank[file], makeSquare(file, 7));
+    }
+
+    castlingRights_ = AllCastling;
+    refreshKey();
+}
+
+void Position::putPiece(Color color, PieceType type, int square) {
+    Bitboard bit = squareBit(square);
+    byType_[static_cast<int>(type)] |= bit;
+    byColor_[static_cast<int>(color)] |= bit;
+    board_[square] = static_cast<std::uint8_t>((static_cast<int>(color) << 3) | static_cast<int>(type));
+    key_ ^= Zobrist::keys.pieces[static_cast<int>(color)][static_cast<int>(type)][square];
+    materialKey_ += std::uint64_t(1) << materialShift(color, type);
+}
+
+void Position::removePiece(int square) {
+    if (board_[square] == EmptySquare) return;
+    Bitboard bit = squareBit(square);
+    int type = static_cast<int>(pieceTypeAt(square));
+    int color = static_cast<int>(colorAt(square));
+    byType_[type] &= ~bit;
+    byColor_[color] &= ~bit;
+    board_[square] = EmptySquare;
+    key_ ^= Zobrist::keys.pieces[color][type][square];
+    materialKey_ -= std::uint64_t(1) << materialShift(static_cast<Color>(color), static_cast<PieceType>(type));
+}
+
+void Position::movePiece(int from, int to) {
+    Color color = colorAt(from);
+    PieceType type = pieceTypeAt(from);
+    removePiece(from);
+    putPiece(color, type, to);
+}
+
+int Position::kingSquare(Color color) const {
+    Bitboard king = pieces(color, PieceType::King);
+    return king ? lsb(king) : NoSquare;
+}
+
+void Position::doMove(Move move) {
+    UndoInfo undo;
+    doMove(move, undo);
+}
+
+void Position::doMove(Move move, UndoInfo& undo) {
+    int from = move.from();
+    int to = move.to();
+    Color us = colorAt(from);
+
+    undo.key = key_;
+    undo.captured = move.flag() == MoveFlag::EnPassant ? PieceType::Pawn : pieceTypeAt(to);
+    undo.castlingRights = castlingRights_;
+    undo.epSquare = epSquare_;
+    undo.halfmoveClock = halfmoveClock_;
+
+    key_ ^= enPassantKey() ^ Zobrist::keys.castling[castlingRights_];
+    castlingRights_ &= ~(castlingRightsLostOn(from) | castlingRightsLostOn(to));
+    epSquare_ = NoSquare;
+
+    if (pieceTypeAt(from) == PieceType::Pawn || undo.captured != PieceType::None) {
+        halfmoveClock_ = 0;
+    }
+    else if (halfmoveClock_ < MaxHalfmoveClock) {
+        halfmoveClock_++;
+    }
+
+    switch (move.flag()) {
+    case MoveFlag::EnPassant:
+        // The captured pawn sits behind the target square
+        removePiece(us == Color::White ? to - 8 : to + 8);
+        movePiece(from, to);
+        break;
+    case MoveFlag::Castling: {
+        bool kingside = to > from;
+        movePiece(from, to);
+        movePiece(kingside ? from + 3 : from - 4, kingside ? from + 1 : from - 1);
+        break;
+    }
+    case MoveFlag::Promotion:
+        removePiece(to);
+        removePiece(from);
+        putPiece(us, move.promotion(), to);
+        break;
+    default:
+        removePiece(to);
+        movePiece(from, to);
+        if (pieceTypeAt(to) == PieceType::Pawn && std::abs(to - from) == 16) {
+            epSquare_ = static_cast<std::int8_t>((from + to) / 2);
+        }
+        break;
+    }
+
+    sideToMove_ = opposite(sideToMove_);
+    key_ ^= Zobrist::keys.blackToMove ^ Zobrist::keys.castling[castlingRights_] ^ enPassantKey();
+}
+
+void Position::undoMove(Move move, const UndoInfo& undo) {
+    int from = move.from();
+    int to = move.to();
+    Color us = opposite(sideToMove_);
+    Color them = sideToMove_;
+
+    switch (move.flag()) {
+    case MoveFlag::EnPassant:
+        movePiece(to, from);
+        putPiece(them, PieceType::Pawn, us == Color::White ? to - 8 : to + 8);
+        break;
+    case MoveFlag::Castling: {
+        bool kingside = to > from;
+        movePiece(to, from);
+        movePiece(kingside ? from + 1 : from - 1, kingside ? from + 3 : from - 4);
+        break;
+    }
+    case MoveFlag::Promotion:
+        removePiece(to);
+        putPiece(us, PieceType::Pawn, from);
+        if (undo.captured != PieceType::None) putPiece(them, undo.captured, to);
+        break;
+    default:
+        movePiece(to, from);
+        if (undo.captured != PieceType::None) putPiece(them, undo.captured, to);
+        break;
+    }
+
+    sideToMove_ = us;
+    castlingRights_ = undo.castlingRights;
+    epSquare_ = undo.epSquare;
+    halfmoveClock_ = undo.halfmoveClock;
+    key_ = undo.key;
+}
+
+void Position::refreshKey() {
+    key_ = 0;
+    Bitboard occupied = this->occupied();
+    while (occupied) {
+        int square = popLsb(occupied);
+        key_ ^= Zobrist::keys.pieces[static_cast<int>(colorAt(square))][static_cast<int>(pieceTypeAt(square))][square];
+    }
+
+    key_ ^= Zobrist::keys.castling[castlingRights_] ^ enPassantKey();
+    if (sideToMove_ == Color::Black) key_ ^= Zobrist::keys.blackToMove;
+}
+
+// The en passant file only counts when a pawn of the side to move could capture,
+// so positions that differ only by an unusable en passant square share a key
+std::uint64_t Position::enPassantKey() const {
+    if (epSquare_ == NoSquare) return 0;
+    if (!(Attacks::pawnAttacks(opposite(sideToMove_), epSquare_) & pieces(sideToMove_, PieceType::Pawn))) return 0;
+    return Zobrist::keys.enPassant[fileOf(epSquare_)];
+}
+
+bool Position::isSquareAttacked(int square, Color attacker) const {
+    Bitboard them = pieces(attacker);
+    Bitboard occupied = this->occupied();
+
+    // A square is attacked by a pawn if a pawn of ours standing there would attack that pawn
+    return (Attacks::pawnAttacks(opposite(attacker), square) & them & pieces(PieceType::Pawn)) ||
+        (Attacks::knightAttacks(square) & them & pieces(PieceType::Knight)) ||
+        (Attacks::kingAttacks(square) & them & pieces(PieceType::King)) ||
+        (Attacks::bishopAttacks(square, occupied) & them & (pieces(PieceType::Bishop) | pieces(PieceType::Queen))) ||
+        (Attacks::rookAttacks(square, occupied) & them & (pieces(PieceType::Rook) | pieces(PieceType::Queen)));
+}
+
+Bitboard Position::attackersTo(int square, Bitboard occupied) const {
+    return (Attacks::pawnAttacks(Color::White, square) & pieces(Color::Black, PieceType::Pawn)) |
+        (Attacks::pawnAttacks(Color::Black, square) & pieces(Color::White, PieceType::Pawn)) |
+        (Attacks::knightAttacks(square) & pieces(PieceType::Knight)) |
+        (Attacks::kingAttacks(square) & pieces(PieceType::King)) |
+        (Attacks::bishopAttacks(square, occupied) & (pieces(PieceType::Bishop) | pieces(PieceType::Queen))) |
+        (Attacks::rookAttacks(square, occupied) & (pieces(PieceType::Rook) | pieces(PieceType::Queen)));
+}
+
+bool Position::hasInsufficientMaterial() const {
+    // Any pawn, rook or queen can still force mate
+    std::uint64_t heavy = 0;
+    for (Color color : { Color::White, Color::Black }) {
+        for (PieceType type : { PieceType::Pawn, PieceType::Rook, PieceType::Queen }) {
+            heavy |= std::uint64_t(15) << materialShift(color, type);
+        }
+    }
+    if (materialKey_ & heavy) return false;
+
+    int knights = pieceCount(Color::White, PieceType::Knight) + pieceCount(Color::Black, PieceType::Knight);
+    int bishops = pieceCount(Color::White, PieceType::Bishop) + pieceCount(Color::Black, PieceType::Bishop);
+    if (knights + bishops <= 1) return true;
+    if (knights > 0) return false;
+
+    // Bishops that all stand on one square color can never cover the king's escape squares
+    constexpr Bitboard DarkSquares = 0xAA55AA55AA55AA55ULL;
+    Bitboard bishopSet = pieces(PieceType::Bishop);
+    return !(bishopSet & DarkSquares) || !(bishopSet & ~DarkSquares);
+}
+
+bool Position::isInCheck(Color color) const {
+    int king = kingSquare(color);
+    return king != NoSquare && isSquareAttacked(king, opposite(color));
+}
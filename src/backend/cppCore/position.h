@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include "bitboard.h"
+#include "move.h"
+
+enum CastlingRight : std::uint8_t {
+    WhiteKingside = 1,
+    WhiteQueenside = 2,
+    BlackKingside = 4,
+    BlackQueenside = 8,
+    AllCastling = 15
+};
+
+/**
+ * @brief State that doMove overwrites and undoMove needs back.
+ */
+struct UndoInfo {
+    std::uint64_t key;
+    PieceType captured;
+    std::uint8_t castlingRights;
+    std::int8_t epSquare;
+    std::uint16_t halfmoveClock;
+};
+
+/**
+ * @brief Bitboard chess position.
+ *
+ * Pieces are kept twice: as one bitboard per piece type and per color for set
+ * operations, and as a 64-byte mailbox for constant-time "what is on this square"
+ * lookups. The class is trivially copyable, so a position can be copied with a
+ * plain memcpy-sized assignment.
+ */
+class Position {
+public:
+    /// Largest halfmove clock a position holds; doMove stops counting there.
+    static constexpr int MaxHalfmoveClock = 65535;
+
+    Position();
+
+    void clear();
+    void setStartPosition();
+
+    void putPiece(Color color, PieceType type, int square);
+    void removePiece(int square);
+    void movePiece(int from, int to);
+
+    /**
+     * @brief Plays a move without checking its legality.
+     *
+     * Handles captures, castling, en passant and promotion as given by the move
+     * flag, and updates castling rights, the en passant square and the side to move.
+     */
+    void doMove(Move move);
+    void doMove(Move move, UndoInfo& undo);
+
+    /**
+     * @brief Takes back a move played with doMove, restoring the state saved in undo.
+     */
+    void undoMove(Move move, const UndoInfo& undo);
+
+    PieceType pieceTypeAt(int square) const { return static_cast<PieceType>(board_[square] & 7); }
+    Color colorAt(int square) const { return isEmpty(square) ? Color::None : static_cast<Color>(board_[square] >> 3); }
+    bool isEmpty(int square) const { return board_[square] == EmptySquare; }
+
+    Bitboard pieces(Color color) const { return byColor_[static_cast<int>(color)]; }
+    Bitboard pieces(PieceType type) const { return byType_[static_cast<int>(type)]; }
+    Bitboard pieces(Color color, PieceType type) const { return pieces(color) & pieces(type); }
+    Bitboard occupied() const { return byColor_[0] | byColor_[1]; }
+    int kingSquare(Color color) const;
+
+    /**
+     * @brief Whether any piece of the given color attacks the square.
+     */
+    bool isSquareAttacked(int square, Color attacker) const;
+
+    /**
+     * @brief All pieces of either color attacking the square, given an occupancy.
+     */
+    Bitboard attackersTo(int square, Bitboard occupied) const;
+    bool isInCheck(Color color) const;
+
+    Color sideToMove() const { return sideToMove_; }
+    void setSideToMove(Color color) { sideToMove_ = color; }
+
+    std::uint8_t castlingRights() const { return castlingRights_; }
+    void setCastlingRights(std::uint8_t rights) { castlingRights_ = rights; }
+
+    int enPassantSquare() const { return epSquare_; }
+    void setEnPassantSquare(int square) { epSquare_ = static_cast<std::int8_t>(square); }
+
+    /**
+     * @brief Plies since the last capture or pawn move.
+     */
+    int halfmoveClock() const { return halfmoveClock_; }
+
+    /**
+     * @brief Sets the halfmove clock; clock must be between 0 and MaxHalfmoveClock.
+     */
+    void setHalfmoveClock(int clock) { halfmoveClock_ = static_cast<std::uint16_t>(clock); }
+
+    /**
+     * @brief 64-bit Zobrist key of the position, maintained incrementally by doMove.
+     */
+    std::uint64_t key() const { return key_; }
+
+    /**
+     * @brief Material signature: the count of every (color, piece type) packed 4 bits each.
+     *
+     * Maintained by putPiece and removePiece, so equal material means an equal signature.
+     */
+    std::uint64_t materialKey() const { return materialKey_; }
+    int pieceCount(Color color, PieceType type) const { return static_cast<int>((materialKey_ >> materialShift(color, type)) & 15); }
+
+    /**
+     * @brief Neither side can ever mate: bare kings, a single minor piece, or only same-colored bishops.
+     */
+    bool hasInsufficientMaterial() const;
+
+    /**
+     * @brief Recomputes the key from scratch, e.g. after setting up a position piece by piece.
+     */
+    void refreshKey();
+
+private:
+    std::uint64_t enPassantKey() const;
+
+    static constexpr int materialShift(Color color, PieceType type) {
+        return (static_cast<int>(color) * 6 + static_cast<int>(type)) * 4;
+    }
+
+    static constexpr std::uint8_t EmptySquare = static_cast<std::uint8_t>(PieceType::None);
+
+    Bitboard byType_[6];
+    Bitboard byColor_[2];
+    std::uint8_t board_[64];
+    Color sideToMove_;
+    std::uint8_t castlingRights_;
+    std::int8_t epSquare_;
+    std::uint16_t halfmoveClock_;
+    std::uint64_t key_;
+    std::uint64_t materialKey_;
+};
@@ -0,0 +1,168 @@
+#include "childProcess.h"
+#include "stockfishProcess.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Engine process regression tests, run against the scriptable fake engine.
+ *
+ * Usage:
+ *   processTest [--python <interpreter>] [--engine <path to fakeEngine.py>]
+ *
+ * Covers a normal search, output split mid-line, a child that crashes mid-search,
+ * a search with no bestmove before its deadline, writing to a child that has
+ * exited, and an engine that never completes the UCI handshake. Exits non-zero if any check fails.
+ */
+
+namespace {
+#ifdef _WIN32
+    const char* DefaultPython = "python";
+#else
+    const char* DefaultPython = "python3";
+#endif
+
+    struct Options {
+        std::string python = DefaultPython;
+        std::string engine = "fakeEngine.py";
+    };
+
+    bool parseOptions(int argc, char* argv[], Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) return false;
+            if (arg == "--python") options.python = argv[++i];
+            else if (arg == "--engine") options.engine = argv[++i];
+            else return false;
+        }
+        return true;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    struct SearchOutcome {
+        bool finished = false;
+        int infoCount = 0;
+        Uci::Info lastInfo;
+        Uci::BestMove bestMove;
+        double seconds = 0;
+    };
+
+    SearchOutcome runSearch(StockfishProcess& engine, std::chrono::milliseconds timeout) {
+        SearchOutcome outcome;
+        auto start = std::chrono::steady_clock::now();
+        if (engine.sendCommand("position startpos\ngo depth 3\n")) {
+            outcome.finished = engine.readSearch([&](const Uci::Info& info) {
+                outcome.infoCount++;
+                outcome.lastInfo = info;
+                }, outcome.bestMove, timeout);
+        }
+        outcome.seconds = secondsSince(start);
+        return outcome;
+    }
+
+    bool isExpectedSearch(const SearchOutcome& outcome) {
+        return outcome.finished && outcome.infoCount == 3 && outcome.lastInfo.depth == 3 && outcome.lastInfo.score == 13
+            && outcome.lastInfo.pvLength == 2 && outcome.bestMove.move.toUci() == "e2e4" && outcome.bestMove.ponder.toUci() == "e7e5";
+    }
+
+    bool testNormalSearch(const Options& options) {
+        StockfishProcess engine;
+        if (!engine.start(options.python, { options.engine, "normal" })) return false;
+        std::string ready;
+        if (!engine.sendCommandAndWait("isready\n", "readyok", ready, std::chrono::seconds(5))) return false;
+        return isExpectedSearch(runSearch(engine, std::chrono::seconds(5)));
+    }
+
+    bool testPartialLines(const Options& options) {
+        // Every line arrives in two writes, so the reader must hold back incomplete lines
+        StockfishProcess engine;
+        if (!engine.start(options.python, { options.engine, "partial" })) return false;
+        return isExpectedSearch(runSearch(engine, std::chrono::seconds(5)));
+    }
+
+    bool testCrashMidSearch(const Options& options) {
+        // The reader must see end of file and give up at once, not wait out the timeout
+        StockfishProcess engine;
+        if (!engine.start(options.python, { options.engine, "crash" })) return false;
+        SearchOutcome outcome = runSearch(engine, std::chrono::seconds(10));
+        return !outcome.finished && outcome.infoCount == 1 && outcome.seconds < 5;
+    }
+
+    bool testMissingBestMove(const Options& options) {
+        StockfishProcess engine;
+        if (!engine.start(options.python, { options.engine, "silent" })) return false;
+        SearchOutcome outcome = runSearch(engine, std::chrono::milliseconds(300));
+        if (outcome.finished || outcome.infoCount != 1 || outcome.seconds < 0.25 || outcome.seconds > 3) return false;
+
+        // A stop the engine ignores still ends in a timeout rather than a hang
+        Uci::BestMove bestMove;
+        if (!engine.sendCommand("stop\n")) return false;
+        return !engine.readSearch([](const Uci::Info&) {}, bestMove, std::chrono::milliseconds(200));
+    }
+
+    bool testWriteAfterExit(const Options& options) {
+        StockfishProcess engine;
+        if (!engine.start(options.python, { options.engine, "quit" })) return false;
+
+        // Once the child is gone a write fails with EPIPE (or ERROR_NO_DATA) instead of killing us with SIGPIPE
+        bool writeFailed = false;
+        auto start = std::chrono::steady_clock::now();
+        while (!writeFailed && secondsSince(start) < 5) {
+            writeFailed = !engine.sendCommand("isready\n");
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        std::string ready;
+        return writeFailed && !engine.readUntil("readyok", ready, std::chrono::seconds(5)) && secondsSince(start) < 5;
+    }
+
+    bool testMissingHandshake(const Options& options) {
+        // An engine that never sends uciok fails to start after the handshake timeout instead of hanging
+        StockfishProcess engine;
+        auto start = std::chrono::steady_clock::now();
+        bool started = engine.start(options.python, { options.engine, "mute" });
+        double seconds = secondsSince(start);
+        return !started && seconds > 4 && seconds < 10;
+    }
+
+    bool testMissingExecutable(const Options&) {
+        ChildProcess process;
+        return !process.start("./no-such-engine-executable");
+    }
+
+    struct Test {
+        const char* name;
+        bool (*run)(const Options& options);
+    };
+
+    const Test Tests[] = {
+        { "normal search", testNormalSearch },
+        { "partial lines", testPartialLines },
+        { "crash mid-search", testCrashMidSearch },
+        { "no bestmove by deadline", testMissingBestMove },
+        { "write after exit", testWriteAfterExit },
+        { "no uciok", testMissingHandshake },
+        { "missing executable", testMissingExecutable },
+    };
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: processTest [--python <interpreter>] [--engine <path to fakeEngine.py>]" << std::endl;
+        return 2;
+    }
+
+    int failures = 0;
+    for (const auto& test : Tests) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = test.run(options);
+        if (!ok) failures++;
+        std::cout << (ok ? "[ OK ] " : "[FAIL] ") << test.name << " (" << secondsSince(start) << " s)" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
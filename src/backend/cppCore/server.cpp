@@ -1,11 +1,58 @@
 #include "server.h"
+#include "utility.h"
 #include <iostream>
+#include <thread>
 
-Server::Server(const std::string& stockfishPath, const std::string& llamaPath, const std::string& modelPath)
-    : chessRoutes_(stockfishPath),
-    llamaRoutes_(llamaPath, modelPath) {
+namespace {
+    /**
+     * @brief Sets value from a variable, leaving it alone if the variable is unset.
+     */
+    void readString(const std::string& name, const std::string& filename, std::string& value) {
+        std::string text = Utility::read_env(name, filename);
+        if (!text.empty()) {
+            value = text;
+        }
+    }
+
+    /**
+     * @brief Sets value from an integer variable, leaving it alone if the variable is unset.
+     */
+    void readInt(const std::string& name, const std::string& filename, int& value) {
+        std::string text = Utility::read_env(name, filename);
+        if (!text.empty()) {
+            value = std::stoi(text);
+        }
+    }
+}
+
+ServerSettings Server::readSettings(const std::string& filename) {
+    ServerSettings settings;
+    readString("STOCKFISH_PATH", filename, settings.stockfishPath);
+    readString("LLAMA_PATH", filename, settings.llamaPath);
+    readString("MODEL_PATH", filename, settings.modelPath);
+    readInt("PORT", filename, settings.port);
+
+    // Leave room for the HTTP and llama threads
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    settings.engineCount = threads > 1 ? threads / 2 : 1;
+    readInt("STOCKFISH_ENGINES", filename, settings.engineCount);
+
+    settings.book.path = Utility::read_env("BOOK_PATH", filename);
+    readInt("BOOK_PLIES", filename, settings.book.maxPly);
+    readInt("BOOK_VARIETY", filename, settings.book.variety);
+
+    settings.tablebases.path = Utility::read_env("SYZYGY_PATH", filename);
+    readInt("SYZYGY_PIECES", filename, settings.tablebases.maxPieces);
+
+    settings.analysisCache.path = Utility::read_env("ANALYSIS_CACHE_PATH", filename);
+    readInt("ANALYSIS_CACHE_MB", filename, settings.analysisCache.sizeMb);
+    return settings;
 }
 
+Server::Server(const ServerSettings& settings)
+    : chessRoutes_(settings.stockfishPath, settings.engineCount, settings.book, settings.tablebases, settings.analysisCache),
+    llamaRoutes_(settings.llamaPath, settings.modelPath) {
+}
 void Server::start(const std::string& address, int port) {
     httplib::Server svr;
 
@@ -2,12 +2,35 @@
 
 #include <string>
 #include "external/httplib.h"
-#include "ChessRoutes.h"
-#include "LlamaRoutes.h"
+#include "chessRoutes.h"
+#include "llamaRoutes.h"
+
+/**
+ * @brief What the server is configured with from its environment file.
+ */
+struct ServerSettings {
+    std::string stockfishPath = "stockfish";    ///< Looked up on PATH unless it contains a directory.
+    std::string llamaPath = "llama-cli";        ///< Looked up on PATH unless it contains a directory.
+    std::string modelPath;                      ///< GGUF model llama.cpp loads; chat is unavailable without one.
+    int port = 1337;
+    int engineCount = 1;                    ///< Stockfish processes to run.
+    OpeningBook::Settings book;             ///< None if the path is empty.
+    SyzygyTablebases::Settings tablebases;  ///< None if the path is empty.
+    AnalysisCache::Settings analysisCache;  ///< None if the path is empty.
+};
 
 class Server {
 public:
-    Server(const std::string& stockfishPath, const std::string& llamaPath, const std::string& modelPath);
+    /**
+     * @brief Reads STOCKFISH_PATH, LLAMA_PATH, MODEL_PATH, PORT, STOCKFISH_ENGINES, BOOK_PATH, BOOK_PLIES,
+     * BOOK_VARIETY, SYZYGY_PATH, SYZYGY_PIECES, ANALYSIS_CACHE_PATH and ANALYSIS_CACHE_MB.
+     * @param filename The file contains the environment variables,
+     * default is ".env"
+     * @return The settings, with defaults for unset variables; the engine count defaults to half the hardware threads.
+     */
+    static ServerSettings readSettings(const std::string& filename = ".env");
+
+    explicit Server(const ServerSettings& settings = ServerSettings());
     void start(const std::string& address, int port);
 
 private:
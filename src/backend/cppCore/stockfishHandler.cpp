@@ -1,34 +1,452 @@
 #include "stockfishHandler.h"
-#include "StockfishProcess.h"
+#include "stockfishProcess.h"
+#include "fen.h"
+#include "enginePool.h"
+#include "moveGen.h"
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <sstream>
+#include <unordered_map>
 #include <iostream>
 
-static std::unique_ptr<StockfishProcess> g_stockfish;
-static std::once_flag g_stockfish_once;
+namespace {
+    /**
+     * @brief An engine thinking, between requests, on the position it expects after its own move and the predicted reply.
+     */
+    struct Ponder {
+        explicit Ponder(EnginePool::Lease&& lease) : lease(std::move(lease)) {}
 
-void ensureStockfish(const std::string& stockfishPath) {
-    std::call_once(g_stockfish_once, [&]() {
-        g_stockfish = std::make_unique<StockfishProcess>(stockfishPath);
+        EnginePool::Lease lease;
+        std::uint64_t afterMoveKey = 0; ///< Key of the position after the engine's own move, on the way to the pondered one.
+        std::uint64_t expectedKey = 0;  ///< Key of the position being pondered.
+        std::string goCommand;          ///< The search that ponderhit turns it into.
+        std::uint64_t startedAt = 0;
+    };
+}
+
+static std::unique_ptr<EnginePool> g_enginePool;
+static std::once_flag g_enginePool_once;
+static std::atomic<int> g_engineCount(1);
+static BestMoveCache g_bestMoveCache(4096);
+static AnalysisCache g_analysisCache;
+static std::mutex g_activeSearches_mutex;
+static std::unordered_multimap<std::string, SearchControl*> g_activeSearches; // Queued and running searches by game
+static std::mutex g_ponders_mutex;
+static std::unordered_map<std::string, std::unique_ptr<Ponder>> g_ponders; // At most one per game; declared after the pool it leases from
+static std::uint64_t g_ponderCounter = 0;
+
+namespace {
+    /// Depth searched when the caller sets no limit at all.
+    const int DefaultDepth = 16;
+
+    /// How long a stopped engine gets to report its move before it is treated as hung.
+    const std::chrono::seconds StopGrace(2);
+
+    /**
+     * @brief Keeps a search listed under its game, for stopSearches(), while in scope.
+     */
+    class ActiveSearch {
+    public:
+        ActiveSearch(const std::string& gameId, SearchControl* control) : gameId_(gameId), control_(control) {
+            if (gameId_.empty()) return;
+            std::lock_guard<std::mutex> lock(g_activeSearches_mutex);
+            g_activeSearches.emplace(gameId_, control_);
+        }
+
+        ~ActiveSearch() {
+            if (gameId_.empty()) return;
+            std::lock_guard<std::mutex> lock(g_activeSearches_mutex);
+            auto range = g_activeSearches.equal_range(gameId_);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == control_) {
+                    g_activeSearches.erase(it);
+                    break;
+                }
+            }
+        }
+
+    private:
+        std::string gameId_;
+        SearchControl* control_;
+    };
+
+    bool hasEngineBound(const SearchLimits& limits) {
+        return limits.depth > 0 || !limits.depthOnly();
+    }
+
+    /**
+     * @brief The depth a search is bounded by, or 0 if something other than depth bounds it.
+     */
+    int limitedDepth(const SearchLimits& limits) {
+        if (!limits.depthOnly()) return 0;
+        if (limits.depth > 0) return limits.depth;
+        return limits.deadlineMs > 0 ? 0 : DefaultDepth;
+    }
+
+    /**
+     * @brief Removes the game's ponder search from the registry, if it has one and keep does not say it should go on running.
+     */
+    std::unique_ptr<Ponder> takePonderUnless(const std::string& gameId, const std::function<bool(const Ponder&)>& keep) {
+        std::lock_guard<std::mutex> lock(g_ponders_mutex);
+        auto it = g_ponders.find(gameId);
+        if (it == g_ponders.end() || keep(*it->second)) return nullptr;
+
+        std::unique_ptr<Ponder> ponder = std::move(it->second);
+        g_ponders.erase(it);
+        return ponder;
+    }
+
+    /**
+     * @brief Removes the game's ponder search from the registry, if it has one.
+     */
+    std::unique_ptr<Ponder> takePonder(const std::string& gameId) {
+        return takePonderUnless(gameId, [](const Ponder&) { return false; });
+    }
+
+    /**
+     * @brief Stops a ponder search nobody wants any more and returns its engine to the pool.
+     */
+    void abandonPonder(std::unique_ptr<Ponder> ponder) {
+        if (!ponder) return;
+
+        StockfishProcess& engine = ponder->lease.engine();
+        Uci::BestMove ignored;
+        if (!engine.sendCommand("stop\n") || !engine.readSearch([](const Uci::Info&) {}, ignored, StopGrace)) {
+            ponder->lease.discard();
+        }
+    }
+
+    /**
+     * @brief Gives the engine of the longest-running ponder search back, for a request that found the pool busy.
+     */
+    void reclaimPonderEngine() {
+        std::unique_ptr<Ponder> oldest;
+        {
+            std::lock_guard<std::mutex> lock(g_ponders_mutex);
+            auto oldestIt = g_ponders.end();
+            for (auto it = g_ponders.begin(); it != g_ponders.end(); ++it) {
+                if (oldestIt == g_ponders.end() || it->second->startedAt < oldestIt->second->startedAt) {
+                    oldestIt = it;
+                }
+            }
+            if (oldestIt == g_ponders.end()) return;
+
+            oldest = std::move(oldestIt->second);
+            g_ponders.erase(oldestIt);
+        }
+        abandonPonder(std::move(oldest));
+    }
+
+    /**
+     * @brief Plays a move decoded from UCI, which lacks the castling and en passant flags, if it is legal.
+     */
+    bool playUciMove(Position& position, Move uciMove) {
+        Move move;
+        if (!MoveGen::findLegalMove(position, uciMove.from(), uciMove.to(), uciMove.promotion(), move)) return false;
+        position.doMove(move);
+        return true;
+    }
+
+    /**
+     * @brief Extends the arguments of a "position" command by further moves.
+     */
+    std::string withMoves(const std::string& enginePosition, const std::string& moves) {
+        return enginePosition + (enginePosition.find(" moves ") == std::string::npos ? " moves " : " ") + moves;
+    }
+
+    /**
+     * @brief Keeps the engine thinking on the predicted reply until the game's next search.
+     *
+     * The lease is only taken over if pondering starts; it is left alone when the
+     * prediction is not legal or a request is already waiting for an engine.
+     */
+    void startPonder(EnginePool& pool, EnginePool::Lease&& lease, const std::string& gameId, const std::string& enginePosition,
+        Position position, const Uci::BestMove& bestMove, const std::string& goCommand) {
+        if (!playUciMove(position, bestMove.move)) return;
+        std::uint64_t afterMoveKey = position.key();
+        if (!playUciMove(position, bestMove.ponder)) return;
+
+        // Same limits as the search ponderhit will turn this into
+        std::string command = "position " + withMoves(enginePosition, bestMove.move.toUci() + " " + bestMove.ponder.toUci()) +
+            "\ngo ponder" + goCommand.substr(2);
+
+        std::unique_ptr<Ponder> replaced;
+        {
+            // Registered before a new waiter can look for ponder searches to reclaim
+            std::lock_guard<std::mutex> lock(g_ponders_mutex);
+            if (pool.hasWaiters()) return;
+            if (!lease.engine().sendCommand(command)) {
+                lease.discard();
+                return;
+            }
+
+            auto ponder = std::make_unique<Ponder>(std::move(lease));
+            ponder->afterMoveKey = afterMoveKey;
+            ponder->expectedKey = position.key();
+            ponder->goCommand = goCommand;
+            ponder->startedAt = ++g_ponderCounter;
+            replaced = std::move(g_ponders[gameId]);
+            g_ponders[gameId] = std::move(ponder);
+        }
+        abandonPonder(std::move(replaced));
+    }
+
+    void writeGoCommand(const SearchLimits& limits, std::ostringstream& oss) {
+        oss << "go";
+        if (limits.depth > 0) oss << " depth " << limits.depth;
+        if (limits.movetimeMs > 0) oss << " movetime " << limits.movetimeMs;
+        if (limits.nodes > 0) oss << " nodes " << limits.nodes;
+        if (limits.wtimeMs > 0) oss << " wtime " << limits.wtimeMs;
+        if (limits.btimeMs > 0) oss << " btime " << limits.btimeMs;
+        if (limits.wincMs > 0) oss << " winc " << limits.wincMs;
+        if (limits.bincMs > 0) oss << " binc " << limits.bincMs;
+
+        // With only a deadline, think until it passes
+        if (!hasEngineBound(limits)) {
+            if (limits.deadlineMs > 0) oss << " infinite";
+            else oss << " depth " << DefaultDepth;
+        }
+        oss << "\n";
+    }
+}
+
+EnginePool& ensureEnginePool(const std::string& stockfishPath) {
+    std::call_once(g_enginePool_once, [&]() {
+        g_enginePool = std::make_unique<EnginePool>(stockfishPath, g_engineCount.load());
+        g_enginePool->setReclaimer(reclaimPonderEngine);
         });
+    return *g_enginePool;
 }
 
-bool StockfishApiHandler::getBestMoveFromStockfish(const std::string& stockfishPath, const std::string& fen, int depth, std::string& bestmove) {
-    ensureStockfish(stockfishPath);
+void SearchControl::stop() {
+    EnginePool* pool;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_) return;
+
+        stopped_ = true;
+        if (engine_) {
+            engine_->sendCommand("stop\n");
+        }
+        pool = pool_;
+    }
+
+    // A search still queued for an engine gives up its place; the pool's lock is taken after ours is released
+    if (pool) {
+        pool->wakeWaiters();
+    }
+}
+
+bool SearchControl::stopped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stopped_;
+}
+
+void StockfishApiHandler::setEngineCount(int count) {
+    g_engineCount.store(count > 0 ? count : 1);
+}
+
+bool StockfishApiHandler::getBestMoveFromStockfish(const std::string& stockfishPath, const std::string& fen, int depth, std::string& bestmove, const std::string& gameId) {
+    SearchLimits limits;
+    limits.depth = depth;
+    return getBestMoveFromStockfish(stockfishPath, fen, limits, bestmove, gameId);
+}
+
+bool StockfishApiHandler::getBestMoveFromStockfish(const std::string& stockfishPath, const std::string& fen, const SearchLimits& limits, std::string& bestmove,
+    const std::string& gameId, const std::string& history) {
+    SearchResult result;
+    if (!search(stockfishPath, fen, limits, gameId, result, nullptr, nullptr, history)) return false;
+    bestmove = result.bestmove;
+    return true;
+}
+
+bool StockfishApiHandler::search(const std::string& stockfishPath, const std::string& fen, const SearchLimits& limits, const std::string& gameId, SearchResult& result,
+    const std::function<void(const Uci::Info&)>& onInfo, SearchControl* control, const std::string& history) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(limits.deadlineMs);
+    auto timeLeft = [&]() {
+        if (limits.deadlineMs <= 0) return ChildProcess::NoTimeout;
+        auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        return left > std::chrono::milliseconds::zero() ? left : std::chrono::milliseconds::zero();
+        };
+
+    // Key on the Zobrist hash so move-order transpositions and clock differences share an entry
+    Position position;
+    int fullmoveNumber;
+    bool cacheable = Fen::parse(fen, position, fullmoveNumber) == Fen::Error::None;
+    int cacheDepth = limitedDepth(limits);
 
-    // Prepare UCI commands
     std::ostringstream oss;
-    oss << "position fen " << fen << "\n";
-    oss << "go depth " << depth << "\n";
+    writeGoCommand(limits, oss);
+    std::string goCommand = oss.str();
+
+    // If the game's engine has been pondering this very search, it only needs a ponderhit, whether or not this search
+    // ponders in turn. A pondering search also drops a ponder the game has left behind, except at the engine's own move:
+    // the predicted reply is still to come, so that ponder runs on for the next search.
+    std::unique_ptr<Ponder> ponder;
+    bool ponderRunsOn = false;
+    if (!gameId.empty()) {
+        ponder = takePonderUnless(gameId, [&](const Ponder& running) {
+            bool hit = cacheable && running.expectedKey == position.key() && running.goCommand == goCommand;
+            ponderRunsOn = !hit && cacheable && running.afterMoveKey == position.key();
+            return !hit && (ponderRunsOn || !limits.ponder);
+            });
+        if (ponder && (!cacheable || ponder->expectedKey != position.key() || ponder->goCommand != goCommand)) {
+            abandonPonder(std::move(ponder));
+        }
+    }
+
+    if (!ponder && cacheable && cacheDepth > 0) {
+        if (g_bestMoveCache.lookup(position.key(), cacheDepth, result.bestmove)) {
+            result.cached = true;
+            return true;
+        }
+
+        // The disk cache also keeps the line, so its hits come back with the analysis
+        AnalysisCache::Entry stored;
+        if (g_analysisCache.lookup(position.key(), cacheDepth, stored)) {
+            result.bestmove = stored.bestmove.isNone() ? "(none)" : stored.bestmove.toUci();
+            if (!stored.ponder.isNone()) {
+                result.ponder = stored.ponder.toUci();
+            }
+            result.principal = stored.principal;
+            result.cached = true;
+            g_bestMoveCache.store(position.key(), stored.depth, result.bestmove);
+            return true;
+        }
+    }
+
+    SearchControl ownControl;
+    if (!control) control = &ownControl;
+    ActiveSearch active(gameId, control);
+
+    // Nobody is waiting for a search that was stopped before it began
+    if (control->stopped()) {
+        abandonPonder(std::move(ponder));
+        return false;
+    }
+
+    EnginePool& pool = ensureEnginePool(stockfishPath);
+    EnginePool::Lease lease = ponder ? std::move(ponder->lease) : pool.acquire(gameId, timeLeft(), control);
+    if (!lease) return false;
+    StockfishProcess& engine = lease.engine();
+
+    result.ponderhit = ponder != nullptr;
+    ponder.reset();
+
+    // The game's moves let the engine see repetitions and carry its search over from the previous move
+    std::string enginePosition = history.empty() ? "fen " + fen : history;
+    if (!result.ponderhit && !history.empty() && !lease.beginLine(history.substr(0, history.find(" moves ")))) {
+        lease.discard();
+        return false;
+    }
+
+    // Prepare UCI commands
+    std::string command = result.ponderhit ? "ponderhit\n" : "position " + enginePosition + "\n" + goCommand;
+    if (!engine.sendCommand(command)) {
+        lease.discard();
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(control->mutex_);
+        control->engine_ = &engine;
+
+        // A stop that arrived while we waited for an engine applies right away
+        if (control->stopped_) {
+            engine.sendCommand("stop\n");
+        }
+    }
+
+    auto handleInfo = [&](const Uci::Info& info) {
+        if (info.multipv == 1 && info.pvLength > 0) {
+            result.principal = info;
+        }
+        if (onInfo) {
+            onInfo(info);
+        }
+        };
 
-    std::string resultLine;
-    if (!g_stockfish->sendCommand(oss.str())) return false;
-    if (!g_stockfish->readUntil("bestmove", resultLine)) return false;
+    Uci::BestMove bestMove;
+    bool finished = engine.readSearch(handleInfo, bestMove, timeLeft());
+    if (!finished && limits.deadlineMs > 0) {
+        // Out of time: stop and take the best move found so far
+        control->stop();
+        finished = engine.readSearch(handleInfo, bestMove, StopGrace);
+    }
 
-    std::istringstream iss(resultLine);
-    std::string tag, move;
-    iss >> tag >> move;
-    bestmove = move;
+    {
+        std::lock_guard<std::mutex> lock(control->mutex_);
+        control->engine_ = nullptr;
+        result.stopped = control->stopped_;
+    }
+
+    if (!finished) {
+        lease.discard();
+        return false;
+    }
+
+    result.bestmove = bestMove.move.isNone() ? "(none)" : bestMove.move.toUci();
+    if (!bestMove.ponder.isNone()) {
+        result.ponder = bestMove.ponder.toUci();
+    }
+
+    if (cacheable) {
+        const Uci::Info& principal = result.principal;
+        int storedDepth = 0;
+        if (!result.stopped && cacheDepth > 0) {
+            storedDepth = cacheDepth;
+        }
+        else if (principal.pvLength > 0 && principal.bound == Uci::Bound::Exact && principal.pv[0] == bestMove.move) {
+            // A time- or node-bounded search, or one cut short, is as good as the last depth it reported
+            storedDepth = principal.depth;
+        }
+
+        if (storedDepth > 0) {
+            g_bestMoveCache.store(position.key(), storedDepth, result.bestmove);
+
+            AnalysisCache::Entry entry;
+            entry.depth = storedDepth;
+            entry.bestmove = bestMove.move;
+            entry.ponder = bestMove.ponder;
+            entry.principal = principal;
+            g_analysisCache.store(position.key(), entry);
+        }
+    }
+
+    if (limits.ponder && !gameId.empty() && cacheable && !result.stopped && !ponderRunsOn && !bestMove.ponder.isNone()) {
+        startPonder(pool, std::move(lease), gameId, enginePosition, position, bestMove, goCommand);
+    }
     return true;
+}
+
+void StockfishApiHandler::stopSearches(const std::string& gameId) {
+    std::lock_guard<std::mutex> lock(g_activeSearches_mutex);
+    auto range = g_activeSearches.equal_range(gameId);
+    for (auto it = range.first; it != range.second; ++it) {
+        it->second->stop();
+    }
+}
+
+void StockfishApiHandler::stopPondering(const std::string& gameId) {
+    abandonPonder(takePonder(gameId));
+}
+
+void StockfishApiHandler::followPondering(const std::string& gameId, std::uint64_t key) {
+    abandonPonder(takePonderUnless(gameId, [key](const Ponder& running) {
+        return running.afterMoveKey == key || running.expectedKey == key;
+        }));
+}
+
+bool StockfishApiHandler::openAnalysisCache(const AnalysisCache::Settings& settings) {
+    return g_analysisCache.open(settings);
+}
+
+const BestMoveCache& StockfishApiHandler::getCache() {
+    return g_bestMoveCache;
+}
+
+const AnalysisCache& StockfishApiHandler::getAnalysisCache() {
+    return g_analysisCache;
 }
\ No newline at end of file
@@ -1,12 +1,83 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string>
+#include "analysisCache.h"
+#include "bestMoveCache.h"
+#include "uci.h"
+
+/**
+ * @brief Bounds on a search. Zero means unset; with no bound at all the engine searches to depth 16.
+ */
+struct SearchLimits {
+    int depth = 0;
+    int movetimeMs = 0;
+    std::uint64_t nodes = 0;
+    int wtimeMs = 0;            ///< Clocks and increments, left to the engine's own time management.
+    int btimeMs = 0;
+    int wincMs = 0;
+    int bincMs = 0;
+    int deadlineMs = 0;         ///< Enforced by the server, counted from the call: the engine is stopped once it passes.
+    bool ponder = false;        ///< Once the move is found, think on the predicted reply until the game plays it or leaves that line.
+
+    /// True when depth alone bounds the search, so a cached result for that depth answers it.
+    bool depthOnly() const { return movetimeMs == 0 && nodes == 0 && wtimeMs == 0 && btimeMs == 0; }
+};
+
+/**
+ * @brief Outcome of one engine search.
+ */
+struct SearchResult {
+    std::string bestmove;
+    std::string ponder;         ///< Expected reply, empty if the engine gave none.
+    Uci::Info principal;        ///< Last report on the best line; empty when served from the cache.
+    bool cached = false;
+    bool stopped = false;       ///< Cut short by the deadline or a stop; bestmove is the best found so far.
+    bool ponderhit = false;     ///< The engine had been pondering this position since its previous move.
+};
+
+class EnginePool;
+class StockfishProcess;
+
+/**
+ * @brief Lets another thread cut a running search short.
+ *
+ * A search given a SearchControl stops as soon as stop() is called, or never
+ * starts if stop() came first, and returns whatever the engine had found so far.
+ * A search still waiting for a free engine gives up its place in the queue.
+ * A control serves a single search.
+ */
+class SearchControl {
+public:
+    /**
+     * @brief Sends "stop" to the engine if the search is running. Safe to call from any thread, any number of times.
+     */
+    void stop();
+
+    bool stopped() const;
+
+private:
+    friend class EnginePool;
+    friend class StockfishApiHandler;
+
+    mutable std::mutex mutex_;
+    EnginePool* pool_ = nullptr;            ///< Set while the search waits for an engine.
+    StockfishProcess* engine_ = nullptr;    ///< Set while the search is running.
+    bool stopped_ = false;
+};
 
 /**
  * @brief Provides an interface to communicate with the Stockfish chess engine.
  *
  * This class exposes static methods to send FEN positions to Stockfish,
- * request analysis, and retrieve the best move.
+ * request analysis, and retrieve the best move. Searches run on a pool of
+ * engine processes, so several can proceed at once. Results are cached by
+ * position, so repeating or transposing into a searched position skips the engine,
+ * and can also be kept on disk to skip it after a restart.
+ * A game's engine can ponder on the predicted reply while the player thinks,
+ * which answers the game's next search at once if the prediction was right.
  */
 class StockfishApiHandler {
 public:
@@ -16,7 +87,69 @@ public:
      * @param fen The FEN string representing the board position.
      * @param depth The search depth for Stockfish.
      * @param bestmove Output parameter for the best move in UCI format.
+     * @param gameId Game the position belongs to; its searches prefer the same engine.
      * @return True if successful, false otherwise.
      */
-    static bool getBestMoveFromStockfish(const std::string& stockfishPath, const std::string& fen, int depth, std::string& bestmove);
+    static bool getBestMoveFromStockfish(const std::string& stockfishPath, const std::string& fen, int depth, std::string& bestmove, const std::string& gameId = std::string());
+
+    /**
+     * @brief Gets the best move within the given limits.
+     * @param history How the game reached fen, as "position" arguments such as "startpos moves e2e4 e7e5";
+     * the engine is sent this instead of fen so it can see repetitions. Empty to send fen alone.
+     */
+    static bool getBestMoveFromStockfish(const std::string& stockfishPath, const std::string& fen, const SearchLimits& limits, std::string& bestmove,
+        const std::string& gameId = std::string(), const std::string& history = std::string());
+
+    /**
+     * @brief Searches a position like getBestMoveFromStockfish, keeping the engine's analysis.
+     * @param onInfo If set, called with every info line while the search runs.
+     * @param control If set, lets another thread stop the search early.
+     * @param history As for getBestMoveFromStockfish; fen still keys the caches.
+     * @return False if the engine failed, or if the search was stopped or hit its deadline before an engine was free.
+     */
+    static bool search(const std::string& stockfishPath, const std::string& fen, const SearchLimits& limits, const std::string& gameId, SearchResult& result,
+        const std::function<void(const Uci::Info&)>& onInfo = nullptr, SearchControl* control = nullptr, const std::string& history = std::string());
+
+    /**
+     * @brief Stops every search for the game that is queued or running, because its position has moved on.
+     *
+     * The interrupted searches return the best move found so far.
+     */
+    static void stopSearches(const std::string& gameId);
+
+    /**
+     * @brief Stops the game's ponder search, if any, e.g. after a move was taken back.
+     *
+     * A search with SearchLimits::ponder does this itself when the predicted reply was not played.
+     */
+    static void stopPondering(const std::string& gameId);
+
+    /**
+     * @brief Tells the game's ponder search, if any, that a move took the game to the position with Zobrist key key.
+     *
+     * The ponder goes on while the game follows its line, i.e. at the position after the engine's
+     * own move or at the pondered one, and is stopped as soon as the game leaves it.
+     */
+    static void followPondering(const std::string& gameId, std::uint64_t key);
+
+    /**
+     * @brief Sets how many engine processes may run at once. Call before the first search.
+     */
+    static void setEngineCount(int count);
+
+    /**
+     * @brief Opens the persistent result cache, consulted after the in-memory one. Call before the first search.
+     * @return false if the file cannot be created or mapped; searches then run without it.
+     */
+    static bool openAnalysisCache(const AnalysisCache::Settings& settings);
+
+    /**
+     * @brief The result cache consulted before every search, e.g. for its hit and miss counters.
+     */
+    static const BestMoveCache& getCache();
+
+    /**
+     * @brief The persistent result cache; closed unless openAnalysisCache succeeded.
+     */
+    static const AnalysisCache& getAnalysisCache();
 };
\ No newline at end of file
@@ -1,42 +1,46 @@
 #pragma once
+#include <chrono>
 #include <string>
-#include <mutex>
-#include <windows.h>
+#include <vector>
+#include "childProcess.h"
+#include "uci.h"
 
 /**
- * @brief Manages a persistent Stockfish engine process with bidirectional pipes (Windows only).
+ * @brief Manages a persistent Stockfish engine process with bidirectional pipes.
  *
  * This class launches Stockfish as a child process and communicates with it
  * via stdin/stdout pipes. It is thread-safe and allows sending UCI commands
  * and reading responses. The process is started once and only closed on destruction.
  *
  * Usage:
- *   StockfishProcess stockfish("C:\\path\\to\\stockfish.exe");
- *   stockfish.sendCommand("uci\n");
+ *   StockfishProcess stockfish;
+ *   if (!stockfish.start("/path/to/stockfish")) return;
  *   std::string line;
- *   stockfish.readUntil("uciok", line);
+ *   stockfish.sendCommandAndWait("isready\n", "readyok", line);
  */
 class StockfishProcess {
 public:
-    /**
-     * @brief Constructs and launches the Stockfish process.
-     * @param stockfishPath Path to the Stockfish executable.
-     */
-    explicit StockfishProcess(const std::string& stockfishPath);
+    /// How long a started engine gets to answer "uci" with uciok.
+    static constexpr std::chrono::seconds HandshakeTimeout{ 5 };
 
     /**
-     * @brief Destructor. Terminates the Stockfish process and closes all handles.
+     * @brief Launches the Stockfish process and waits for it to answer "uci".
+     * @param stockfishPath Path to the Stockfish executable.
+     * @param args Command line arguments, e.g. the script when the engine runs under an interpreter.
+     * @return false if the process could not be started or sent no uciok within HandshakeTimeout.
      */
-    ~StockfishProcess();
+    bool start(const std::string& stockfishPath, const std::vector<std::string>& args = {});
 
     /**
      * @brief Sends a UCI command to Stockfish and reads output until a line containing the given keyword.
      * @param command The command to send (e.g. "position fen ...").
      * @param waitFor The keyword to wait for in output (e.g. "bestmove").
      * @param resultLine The line containing the keyword will be stored here.
-     * @return true on success, false on error.
+     * @param timeout How long to wait for the keyword.
+     * @return true on success, false on error or timeout.
      */
-    bool sendCommandAndWait(const std::string& command, const std::string& waitFor, std::string& resultLine);
+    bool sendCommandAndWait(const std::string& command, const std::string& waitFor, std::string& resultLine,
+        std::chrono::milliseconds timeout = ChildProcess::NoTimeout);
 
     /**
      * @brief Sends a command to Stockfish.
@@ -49,26 +53,33 @@ public:
      * @brief Reads lines from Stockfish until a line containing the given keyword.
      * @param waitFor The keyword to wait for.
      * @param resultLine The line containing the keyword will be stored here.
+     * @param timeout How long to wait for the keyword.
      * @return true if found, false otherwise.
      */
-    bool readUntil(const std::string& waitFor, std::string& resultLine);
-
-private:
-    HANDLE hProcess_;         ///< Handle to the Stockfish process.
-    HANDLE hThread_;          ///< Handle to the Stockfish main thread.
-    HANDLE hChildStdinWr_;    ///< Write handle to Stockfish's stdin.
-    HANDLE hChildStdoutRd_;   ///< Read handle from Stockfish's stdout.
-    std::mutex mtx_;          ///< Mutex for thread safety.
+    bool readUntil(const std::string& waitFor, std::string& resultLine, std::chrono::milliseconds timeout = ChildProcess::NoTimeout);
 
     /**
-     * @brief Starts the Stockfish process and sets up pipes.
-     * @param stockfishPath Path to the Stockfish executable.
-     * @return true on success, false on failure.
+     * @brief Reads the output of a running "go" until its bestmove line.
+     * @param onInfo Called with each decoded info line as it arrives; the Info is reused between calls.
+     * @param bestMove The decoded bestmove line will be stored here.
+     * @param timeout How long to wait for bestmove; the search keeps running if it passes.
+     * @return true if the search finished, false on timeout or if the engine went away.
      */
-    bool startProcess(const std::string& stockfishPath);
+    template<typename OnInfo>
+    bool readSearch(OnInfo onInfo, Uci::BestMove& bestMove, std::chrono::milliseconds timeout = ChildProcess::NoTimeout);
 
-    /**
-     * @brief Terminates the Stockfish process and closes all handles.
-     */
-    void stopProcess();
-};
\ No newline at end of file
+private:
+    ChildProcess process_;  ///< The engine; terminated when this is destroyed.
+};
+
+template<typename OnInfo>
+bool StockfishProcess::readSearch(OnInfo onInfo, Uci::BestMove& bestMove, std::chrono::milliseconds timeout) {
+    Uci::Info info;
+    return process_.readLines([&](std::string_view line) {
+        if (Uci::parseInfo(line, info)) {
+            onInfo(info);
+            return false;
+        }
+        return Uci::parseBestMove(line, bestMove);
+        }, timeout);
+}
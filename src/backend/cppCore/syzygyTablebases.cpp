@@ -0,0 +1,987 @@
+#include "syzygyTablebases.h"
+#include "attacks.h"
+#include "mappedFile.h"
+#include "moveGen.h"
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+
+namespace {
+    /// Largest tables published: seven pieces, kings included.
+    const int TablePieces = 7;
+
+    /// Flags of one compressed table; all but SingleValue only occur in DTZ files.
+    enum TableFlag : std::uint8_t {
+        StoresBlackToMove = 1,
+        Mapped = 2,
+        WinPlies = 4,
+        LossPlies = 8,
+        Wide = 16,
+        SingleValue = 128
+    };
+
+    /// Magic numbers opening .rtbw and .rtbz files.
+    const unsigned char WdlMagic[4] = { 0x71, 0xE8, 0x23, 0x5D };
+    const unsigned char DtzMagic[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+
+    const char PieceLetters[] = "PNBRQK";
+
+#ifdef _WIN32
+    const char PathSeparator = ';';
+#else
+    const char PathSeparator = ':';
+#endif
+
+    std::uint16_t readLittleEndian16(const unsigned char* bytes) {
+        return static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8));
+    }
+
+    std::uint32_t readLittleEndian32(const unsigned char* bytes) {
+        return static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8)
+            | (static_cast<std::uint32_t>(bytes[2]) << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24);
+    }
+
+    std::uint64_t readBigEndian(const unsigned char* bytes, int length) {
+        std::uint64_t value = 0;
+        for (int i = 0; i < length; i++) {
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+
+    /// Aligns a pointer into the mapping; the mapping itself is page aligned.
+    const unsigned char* alignTo(const unsigned char* data, std::uintptr_t alignment) {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(data);
+        return data + ((alignment - address % alignment) % alignment);
+    }
+
+    /// Pieces are coded as in the table files: type 1-6 from pawn to king, plus 8 for black.
+    int pieceCode(const Position& pos, int square) {
+        return (static_cast<int>(pos.pieceTypeAt(square)) + 1) | (static_cast<int>(pos.colorAt(square)) << 3);
+    }
+
+    int flipFile(int square) { return square ^ 7; }
+    int flipRank(int square) { return square ^ 56; }
+
+    /// Signed distance from the a1-h8 diagonal: negative below it, positive above.
+    int offDiagonal(int square) { return Bitboards::rankOf(square) - Bitboards::fileOf(square); }
+
+    /**
+     * @brief Square numberings the table index is built from, computed once.
+     */
+    struct Indexing {
+        int mapPawns[64];           ///< a2-h7 to 0..47, highest for the pawn nearest the edge on the lowest rank.
+        int mapB1H1H7[64];          ///< The triangle below the a1-h8 diagonal to 0..27.
+        int mapA1D1D4[64];          ///< The a1-d1-d4 triangle to 0..9, diagonal squares last.
+        int mapKK[10][64];          ///< The 462 placements of two kings with the first in a1-d1-d4.
+        std::uint64_t binomial[6][64];    ///< binomial[k][n]: ways to choose k of n squares.
+        std::uint64_t leadPawnIdx[6][64]; ///< Start index of a leading pawn square, by leading pawn count.
+        std::uint64_t leadPawnsSize[6][4];///< Index range of the leading pawns, by count and file a-d.
+
+        Indexing()
+            : mapPawns(), mapB1H1H7(), mapA1D1D4(), mapKK(), binomial(), leadPawnIdx(), leadPawnsSize() {
+            int code = 0;
+            for (int s = 0; s < 64; s++) {
+                if (offDiagonal(s) < 0) mapB1H1H7[s] = code++;
+            }
+
+            std::vector<int> diagonal;
+            code = 0;
+            for (int s = 0; s <= 27; s++) {
+                if (Bitboards::fileOf(s) > 3) continue;
+                if (offDiagonal(s) < 0) {
+                    mapA1D1D4[s] = code++;
+                }
+                else if (offDiagonal(s) == 0) {
+                    diagonal.push_back(s);
+                }
+            }
+            for (int s : diagonal) {
+                mapA1D1D4[s] = code++;
+            }
+
+            // With the first king on the diagonal the second one never goes above it
+            std::vector<std::pair<int, int>> bothOnDiagonal;
+            code = 0;
+            for (int idx = 0; idx < 10; idx++) {
+                for (int s1 = 0; s1 <= 27; s1++) {
+                    // Squares outside the triangle are left at 0, which also numbers b1
+                    if (mapA1D1D4[s1] != idx || (idx == 0 && s1 != 1)) continue;
+                    Bitboard near = Attacks::kingAttacks(s1) | Bitboards::squareBit(s1);
+                    for (int s2 = 0; s2 < 64; s2++) {
+                        if (near & Bitboards::squareBit(s2)) continue;
+                        if (offDiagonal(s1) == 0 && offDiagonal(s2) > 0) continue;
+                        if (offDiagonal(s1) == 0 && offDiagonal(s2) == 0) {
+                            bothOnDiagonal.emplace_back(idx, s2);
+                        }
+                        else {
+                            mapKK[idx][s2] = code++;
+                        }
+                    }
+                }
+            }
+            for (const auto& placement : bothOnDiagonal) {
+                mapKK[placement.first][placement.second] = code++;
+            }
+
+            binomial[0][0] = 1;
+            for (int n = 1; n < 64; n++) {
+                for (int k = 0; k < 6 && k <= n; k++) {
+                    binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+                }
+            }
+
+            int available = 47;
+            for (int leadPawns = 1; leadPawns <= 5; leadPawns++) {
+                for (int file = 0; file < 4; file++) {
+                    std::uint64_t idx = 0;
+                    for (int rank = 1; rank <= 6; rank++) {
+                        int square = Bitboards::makeSquare(file, rank);
+                        if (leadPawns == 1) {
+                            mapPawns[square] = available--;
+                            mapPawns[flipFile(square)] = available--;
+                        }
+                        leadPawnIdx[leadPawns][square] = idx;
+                        idx += binomial[leadPawns - 1][mapPawns[square]];
+                    }
+                    leadPawnsSize[leadPawns][file] = idx;
+                }
+            }
+        }
+    };
+
+    const Indexing& indexing() {
+        static const Indexing tables;
+        return tables;
+    }
+
+    /**
+     * @brief Decoding state of one compressed table: a file holds one per side to move
+     * stored, and per leading pawn file when there are pawns.
+     */
+    struct PairsData {
+        std::uint8_t flags = 0;
+        int maxSymLen = 0;
+        int minSymLen = 0;                          ///< Doubles as the value of a SingleValue table.
+        std::uint32_t numBlocks = 0;
+        std::size_t blockSize = 0;
+        std::size_t span = 0;                       ///< Values between two sparse index entries.
+        const unsigned char* lowestSym = nullptr;   ///< Little-endian 16-bit lowest symbol of each code length.
+        const unsigned char* btree = nullptr;       ///< Two 12-bit child symbols per symbol.
+        const unsigned char* blockLength = nullptr; ///< Little-endian 16-bit value count minus one, per block.
+        std::uint32_t blockLengthSize = 0;
+        const unsigned char* sparseIndex = nullptr; ///< 6-byte entries: 32-bit block and 16-bit offset.
+        std::size_t sparseIndexSize = 0;
+        const unsigned char* data = nullptr;        ///< Huffman-coded blocks.
+        std::vector<std::uint64_t> base64;          ///< Lowest code of each length, left-aligned in 64 bits.
+        std::vector<std::uint8_t> symlen;           ///< Values a symbol expands to, minus one.
+        int pieces[TablePieces] = {};               ///< Piece order of the index; groups are runs of this.
+        std::uint64_t groupIdx[TablePieces + 1] = {};
+        int groupLen[TablePieces + 1] = {};
+        std::uint16_t mapIdx[4] = {};               ///< DTZ value maps for win, loss, cursed win and blessed loss.
+
+        int leftChild(int sym) const {
+            const unsigned char* lr = btree + 3 * sym;
+            return ((lr[1] & 0xF) << 8) | lr[0];
+        }
+
+        int rightChild(int sym) const {
+            const unsigned char* lr = btree + 3 * sym;
+            return (lr[2] << 4) | (lr[1] >> 4);
+        }
+    };
+
+    /**
+     * @brief Looks up the value stored at an index.
+     *
+     * Values are run through recursive pairing, where a symbol stands for a pair
+     * of symbols, then canonical Huffman coded in blocks. The sparse index gives a
+     * block near the one holding the index, the block lengths walk to the right
+     * one, and the block is decoded symbol by symbol until the one covering the index.
+     */
+    int decompressPairs(const PairsData& d, std::uint64_t idx) {
+        if (d.flags & SingleValue) return d.minSymLen;
+
+        std::uint64_t k = idx / d.span;
+        const unsigned char* entry = d.sparseIndex + 6 * k;
+        std::uint32_t block = readLittleEndian32(entry);
+        long long offset = readLittleEndian16(entry + 4);
+
+        // Entry k points at index k * span + span / 2
+        offset += static_cast<long long>(idx % d.span) - static_cast<long long>(d.span / 2);
+
+        while (offset < 0) {
+            offset += readLittleEndian16(d.blockLength + 2 * --block) + 1;
+        }
+        while (offset > readLittleEndian16(d.blockLength + 2 * block)) {
+            offset -= readLittleEndian16(d.blockLength + 2 * block++) + 1;
+        }
+
+        const unsigned char* ptr = d.data + static_cast<std::uint64_t>(block) * d.blockSize;
+        std::uint64_t buf64 = readBigEndian(ptr, 8);
+        ptr += 8;
+        int buf64Size = 64;
+        int sym;
+
+        while (true) {
+            // Shorter codes are numerically larger, so the first base below the
+            // buffer gives the code length
+            int len = 0;
+            while (buf64 < d.base64[len]) {
+                len++;
+            }
+            sym = static_cast<int>((buf64 - d.base64[len]) >> (64 - len - d.minSymLen));
+            sym += readLittleEndian16(d.lowestSym + 2 * len);
+
+            if (offset < d.symlen[sym] + 1) break;
+
+            offset -= d.symlen[sym] + 1;
+            len += d.minSymLen;
+            buf64 <<= len;
+            buf64Size -= len;
+            if (buf64Size <= 32) {
+                buf64Size += 32;
+                buf64 |= readBigEndian(ptr, 4) << (64 - buf64Size);
+                ptr += 4;
+            }
+        }
+
+        // Expand the pair tree down to the single value the offset falls on
+        while (d.symlen[sym]) {
+            int left = d.leftChild(sym);
+            if (offset < d.symlen[left] + 1) {
+                sym = left;
+            }
+            else {
+                offset -= d.symlen[left] + 1;
+                sym = d.rightChild(sym);
+            }
+        }
+        return d.leftChild(sym);
+    }
+
+    bool setSymlen(PairsData& d, int sym, std::vector<bool>& visited) {
+        visited[sym] = true;
+        int right = d.rightChild(sym);
+        if (right == 0xFFF) {
+            d.symlen[sym] = 0;
+            return true;
+        }
+        int left = d.leftChild(sym);
+        if (left >= static_cast<int>(d.symlen.size()) || right >= static_cast<int>(d.symlen.size())) return false;
+        if (!visited[left] && !setSymlen(d, left, visited)) return false;
+        if (!visited[right] && !setSymlen(d, right, visited)) return false;
+        d.symlen[sym] = static_cast<std::uint8_t>(d.symlen[left] + d.symlen[right] + 1);
+        return true;
+    }
+
+    /**
+     * @brief Reads the Huffman code description of one compressed table.
+     * @return The byte after it, or nullptr if it is malformed.
+     */
+    const unsigned char* setSizes(PairsData& d, const unsigned char* data) {
+        d.flags = *data++;
+        if (d.flags & SingleValue) {
+            d.minSymLen = *data++;
+            return data;
+        }
+
+        std::uint64_t tableSize = d.groupIdx[std::find(d.groupLen, d.groupLen + TablePieces, 0) - d.groupLen];
+
+        d.blockSize = std::size_t(1) << *data++;
+        d.span = std::size_t(1) << *data++;
+        d.sparseIndexSize = static_cast<std::size_t>((tableSize + d.span - 1) / d.span);
+        int padding = *data++;
+        d.numBlocks = readLittleEndian32(data);
+        data += 4;
+        // Padded so the sparse index never points past the end
+        d.blockLengthSize = d.numBlocks + padding;
+        d.maxSymLen = *data++;
+        d.minSymLen = *data++;
+        if (d.maxSymLen < d.minSymLen || d.maxSymLen > 32) return nullptr;
+        d.lowestSym = data;
+
+        // Longer codes have lower values, so base64 descends with the code length
+        d.base64.assign(d.maxSymLen - d.minSymLen + 1, 0);
+        for (int i = static_cast<int>(d.base64.size()) - 2; i >= 0; i--) {
+            d.base64[i] = (d.base64[i + 1] + readLittleEndian16(d.lowestSym + 2 * i)
+                - readLittleEndian16(d.lowestSym + 2 * (i + 1))) / 2;
+        }
+        for (std::size_t i = 0; i < d.base64.size(); i++) {
+            d.base64[i] <<= 64 - i - d.minSymLen;
+        }
+        data += d.base64.size() * 2;
+
+        d.symlen.assign(readLittleEndian16(data), 0);
+        data += 2;
+        d.btree = data;
+
+        std::vector<bool> visited(d.symlen.size());
+        for (std::size_t sym = 0; sym < d.symlen.size(); sym++) {
+            if (!visited[sym] && !setSymlen(d, static_cast<int>(sym), visited)) return nullptr;
+        }
+        return data + d.symlen.size() * 3 + (d.symlen.size() & 1);
+    }
+
+    /**
+     * @brief One mapped .rtbw or .rtbz file and the decoding state read from its header.
+     */
+    struct TableFile {
+        std::string path;
+        std::once_flag mapOnce;
+        bool usable = false;
+        MappedFile file;
+        const unsigned char* valueMap = nullptr;    ///< DTZ only: values remapped by frequency.
+        PairsData items[2][4];                      ///< [side to move stored][leading pawn file, or 0 without pawns]
+    };
+}
+
+enum class SyzygyTablebases::ProbeState {
+    Fail,
+    Ok,
+    ChangeStm,          ///< The DTZ file only stores the other side to move.
+    ZeroingBestMove     ///< A capture or pawn move is best, so the stored DTZ value is meaningless.
+};
+
+/**
+ * @brief A material combination such as KRvK, covering both color assignments.
+ */
+struct SyzygyTablebases::Table {
+    std::uint64_t key;          ///< Material key with the file's first side as white.
+    std::uint64_t key2;         ///< Material key with the colors swapped; equal to key for symmetric material.
+    int pieceCount;
+    bool hasPawns;
+    bool hasUniquePieces;
+    std::uint8_t pawnCount[2];  ///< Pawns of the leading color, then of the other.
+    TableFile wdl;
+    TableFile dtz;
+
+    PairsData& pairs(TableFile& part, int stm, int file) {
+        int sides = &part == &wdl ? 2 : 1;
+        return part.items[stm % sides][hasPawns ? file : 0];
+    }
+
+    /**
+     * @brief Splits the piece order into the groups encoded together and sizes each group's index range.
+     *
+     * The first group is the leading pawns, or the kings and a unique piece, or
+     * just the kings. Later groups are runs of identical pieces. The file gives
+     * the order the groups are multiplied in.
+     */
+    bool setGroups(PairsData& d, const int order[2], int file) {
+        const Indexing& ix = indexing();
+        int n = 0;
+        int firstLen = hasPawns ? 0 : hasUniquePieces ? 3 : 2;
+        d.groupLen[n] = 1;
+        for (int i = 1; i < pieceCount; i++) {
+            if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1]) {
+                d.groupLen[n]++;
+            }
+            else {
+                d.groupLen[++n] = 1;
+            }
+        }
+        d.groupLen[++n] = 0;
+
+        for (int g = hasPawns || !hasUniquePieces ? 0 : 1; g < n; g++) {
+            if (d.groupLen[g] > 5) return false;
+        }
+
+        bool bothPawns = hasPawns && pawnCount[1];
+        int next = bothPawns ? 2 : 1;
+        int freeSquares = 64 - d.groupLen[0] - (bothPawns ? d.groupLen[1] : 0);
+        std::uint64_t idx = 1;
+
+        for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+            if (k == order[0]) {
+                d.groupIdx[0] = idx;
+                idx *= hasPawns ? ix.leadPawnsSize[d.groupLen[0]][file] : hasUniquePieces ? 31332 : 462;
+            }
+            else if (k == order[1]) {
+                d.groupIdx[1] = idx;
+                idx *= ix.binomial[d.groupLen[1]][48 - d.groupLen[0]];
+            }
+            else {
+                d.groupIdx[next] = idx;
+                idx *= ix.binomial[d.groupLen[next]][freeSquares];
+                freeSquares -= d.groupLen[next++];
+            }
+            if (k > TablePieces) return false;
+        }
+        d.groupIdx[n] = idx;
+        return true;
+    }
+
+    /**
+     * @brief Lays the decoding state over a freshly mapped file.
+     * @return false if the header does not describe this material or runs past the end.
+     */
+    bool setup(TableFile& part) {
+        const bool isDtz = &part == &dtz;
+        const unsigned char* data = part.file.data();
+        const unsigned char* end = data + part.file.size();
+        if (part.file.size() < 16) return false;
+        if (std::equal(data, data + 4, isDtz ? DtzMagic : WdlMagic) == false) return false;
+        data += 4;
+
+        enum { Split = 1, HasPawns = 2 };
+        if (bool(*data & HasPawns) != hasPawns) return false;
+        if (bool(*data & Split) != (key != key2)) return false;
+        data++;
+
+        const int sides = !isDtz && key != key2 ? 2 : 1;
+        const int maxFile = hasPawns ? 3 : 0;
+        const bool bothPawns = hasPawns && pawnCount[1];
+
+        for (int f = 0; f <= maxFile; f++) {
+            int order[2][2] = {
+                { *data & 0xF, bothPawns ? *(data + 1) & 0xF : 0xF },
+                { *data >> 4, bothPawns ? *(data + 1) >> 4 : 0xF }
+            };
+            data += 1 + bothPawns;
+
+            for (int k = 0; k < pieceCount; k++, data++) {
+                for (int i = 0; i < sides; i++) {
+                    pairs(part, i, f).pieces[k] = i ? *data >> 4 : *data & 0xF;
+                }
+            }
+            for (int i = 0; i < sides; i++) {
+                if (!setGroups(pairs(part, i, f), order[i], f)) return false;
+            }
+        }
+        data = alignTo(data, 2);
+
+        for (int f = 0; f <= maxFile; f++) {
+            for (int i = 0; i < sides; i++) {
+                data = setSizes(pairs(part, i, f), data);
+                if (!data || data > end) return false;
+            }
+        }
+
+        if (isDtz) {
+            part.valueMap = data;
+            for (int f = 0; f <= maxFile; f++) {
+                PairsData& d = pairs(part, 0, f);
+                if (!(d.flags & Mapped)) continue;
+                if (d.flags & Wide) {
+                    data = alignTo(data, 2);
+                    // Four runs of 16-bit values, each preceded by its length
+                    for (int i = 0; i < 4; i++) {
+                        d.mapIdx[i] = static_cast<std::uint16_t>((data - part.valueMap) / 2 + 1);
+                        data += 2 * readLittleEndian16(data) + 2;
+                    }
+                }
+                else {
+                    for (int i = 0; i < 4; i++) {
+                        d.mapIdx[i] = static_cast<std::uint16_t>(data - part.valueMap + 1);
+                        data += *data + 1;
+                    }
+                }
+                if (data > end) return false;
+            }
+            data = alignTo(data, 2);
+        }
+
+        for (int f = 0; f <= maxFile; f++) {
+            for (int i = 0; i < sides; i++) {
+                PairsData& d = pairs(part, i, f);
+                d.sparseIndex = data;
+                data += d.sparseIndexSize * 6;
+            }
+        }
+        for (int f = 0; f <= maxFile; f++) {
+            for (int i = 0; i < sides; i++) {
+                PairsData& d = pairs(part, i, f);
+                d.blockLength = data;
+                data += static_cast<std::size_t>(d.blockLengthSize) * 2;
+            }
+        }
+        for (int f = 0; f <= maxFile; f++) {
+            for (int i = 0; i < sides; i++) {
+                PairsData& d = pairs(part, i, f);
+                data = alignTo(data, 64);
+                d.data = data;
+                data += static_cast<std::size_t>(d.numBlocks) * d.blockSize;
+            }
+        }
+        return data <= end;
+    }
+
+    /**
+     * @brief Maps the file on first use; later calls only read the outcome.
+     */
+    bool ready(TableFile& part) {
+        std::call_once(part.mapOnce, [&] {
+            part.usable = part.file.open(part.path, true) && setup(part);
+            if (!part.usable) part.file.close();
+        });
+        return part.usable;
+    }
+};
+
+namespace {
+    const int WdlToMap[] = { 1, 3, 0, 2, 0 };
+
+    SyzygyTablebases::Wdl negate(SyzygyTablebases::Wdl wdl) {
+        return static_cast<SyzygyTablebases::Wdl>(-static_cast<int>(wdl));
+    }
+
+    /**
+     * @brief DTZ of the move before a capture or pawn move, known from the value alone.
+     */
+    int dtzBeforeZeroing(SyzygyTablebases::Wdl wdl) {
+        switch (wdl) {
+        case SyzygyTablebases::Wdl::Win: return 1;
+        case SyzygyTablebases::Wdl::CursedWin: return 101;
+        case SyzygyTablebases::Wdl::BlessedLoss: return -101;
+        case SyzygyTablebases::Wdl::Loss: return -1;
+        default: return 0;
+        }
+    }
+
+    int signOf(int value) {
+        return (0 < value) - (value < 0);
+    }
+
+    bool isZeroing(const Position& pos, Move move) {
+        return !pos.isEmpty(move.to()) || move.flag() == MoveFlag::EnPassant
+            || pos.pieceTypeAt(move.from()) == PieceType::Pawn;
+    }
+
+    bool isMated(const Position& pos) {
+        if (!pos.isInCheck(pos.sideToMove())) return false;
+        MoveList moves;
+        MoveGen::generateLegalMoves(pos, pos.sideToMove(), moves);
+        return moves.empty();
+    }
+
+    /**
+     * @brief Material key of a table name such as "KRvKN", with the left side as white.
+     * @return false if the name is not a material combination.
+     */
+    bool parseMaterial(const std::string& name, bool swapColors, Position& pos) {
+        pos.clear();
+        std::size_t split = name.find('v');
+        if (split == std::string::npos || split == 0 || split + 1 == name.size()) return false;
+        int square = 0;
+        for (std::size_t i = 0; i < name.size(); i++) {
+            if (i == split) continue;
+            const char* letter = std::find(PieceLetters, PieceLetters + 6, name[i]);
+            if (letter == PieceLetters + 6 || square >= 64) return false;
+            bool first = i < split;
+            Color color = first != swapColors ? Color::White : Color::Black;
+            pos.putPiece(color, static_cast<PieceType>(letter - PieceLetters), square++);
+        }
+        return pos.pieceCount(Color::White, PieceType::King) == 1 && pos.pieceCount(Color::Black, PieceType::King) == 1;
+    }
+}
+
+SyzygyTablebases::SyzygyTablebases()
+    : largestTable_(0),
+    maxPieces_(0) {
+}
+
+SyzygyTablebases::~SyzygyTablebases() = default;
+
+bool SyzygyTablebases::open(const Settings& settings) {
+    close();
+
+    std::size_t start = 0;
+    while (start <= settings.path.size()) {
+        std::size_t stop = settings.path.find(PathSeparator, start);
+        if (stop == std::string::npos) stop = settings.path.size();
+        std::string directory = settings.path.substr(start, stop - start);
+        start = stop + 1;
+        if (directory.empty()) continue;
+
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            const std::filesystem::path& path = entry.path();
+            if (path.extension() != ".rtbw") continue;
+
+            std::string name = path.stem().string();
+            Position white;
+            Position black;
+            if (!parseMaterial(name, false, white) || !parseMaterial(name, true, black)) continue;
+            int pieces = Bitboards::popCount(white.occupied());
+            if (pieces > TablePieces || byMaterial_.count(white.materialKey())) continue;
+
+            auto table = std::make_unique<Table>();
+            table->key = white.materialKey();
+            table->key2 = black.materialKey();
+            table->pieceCount = pieces;
+            table->hasPawns = white.pieces(PieceType::Pawn) != 0;
+            table->hasUniquePieces = false;
+            for (Color color : { Color::White, Color::Black }) {
+                for (int type = 0; type < static_cast<int>(PieceType::King); type++) {
+                    if (white.pieceCount(color, static_cast<PieceType>(type)) == 1) table->hasUniquePieces = true;
+                }
+            }
+
+            // The side with fewer pawns leads, as it compresses better
+            int whitePawns = white.pieceCount(Color::White, PieceType::Pawn);
+            int blackPawns = white.pieceCount(Color::Black, PieceType::Pawn);
+            bool whiteLeads = !blackPawns || (whitePawns && blackPawns >= whitePawns);
+            table->pawnCount[0] = static_cast<std::uint8_t>(whiteLeads ? whitePawns : blackPawns);
+            table->pawnCount[1] = static_cast<std::uint8_t>(whiteLeads ? blackPawns : whitePawns);
+
+            table->wdl.path = path.string();
+            std::filesystem::path dtzPath = path;
+            table->dtz.path = dtzPath.replace_extension(".rtbz").string();
+
+            byMaterial_[table->key] = table.get();
+            byMaterial_[table->key2] = table.get();
+            largestTable_ = std::max(largestTable_, pieces);
+            tables_.push_back(std::move(table));
+        }
+    }
+
+    maxPieces_ = settings.maxPieces > 0 ? std::min(settings.maxPieces, largestTable_) : largestTable_;
+    return isOpen();
+}
+
+void SyzygyTablebases::close() {
+    byMaterial_.clear();
+    tables_.clear();
+    largestTable_ = 0;
+    maxPieces_ = 0;
+}
+
+bool SyzygyTablebases::covers(const Position& position) const {
+    return isOpen() && position.castlingRights() == 0
+        && Bitboards::popCount(position.occupied()) <= maxPieces_;
+}
+
+SyzygyTablebases::Table* SyzygyTablebases::tableFor(const Position& position, bool dtz) const {
+    auto found = byMaterial_.find(position.materialKey());
+    if (found == byMaterial_.end()) return nullptr;
+    Table* table = found->second;
+    return table->ready(dtz ? table->dtz : table->wdl) ? table : nullptr;
+}
+
+/**
+ * @brief Computes the position's index in its table and reads the stored value.
+ *
+ * Tables are stored with the stronger side as white, so the position may be
+ * color-flipped first. Symmetries then bring the leading piece to the a1-d1-d4
+ * triangle, or the leading pawn to files a-d, and each group of pieces is
+ * numbered by its combination of squares.
+ * @return The WDL value, or for DTZ tables the distance in plies.
+ */
+int SyzygyTablebases::probeTable(const Position& pos, bool dtz, Wdl wdl, ProbeState& state) const {
+    if (Bitboards::popCount(pos.occupied()) == 2) return 0;
+
+    Table* table = tableFor(pos, dtz);
+    if (!table) {
+        state = ProbeState::Fail;
+        return 0;
+    }
+    TableFile& part = dtz ? table->dtz : table->wdl;
+    const Indexing& ix = indexing();
+
+    int squares[TablePieces];
+    int pieces[TablePieces];
+    int size = 0;
+    int leadPawnsCount = 0;
+    Bitboard leadPawns = 0;
+    int tableFile = 0;
+    int sideToMove = static_cast<int>(pos.sideToMove());
+
+    bool symmetricBlackToMove = table->key == table->key2 && sideToMove == 1;
+    bool blackStronger = pos.materialKey() != table->key;
+    bool flip = symmetricBlackToMove || blackStronger;
+    int flipColor = flip ? 8 : 0;
+    int flipSquares = flip ? 56 : 0;
+    int stm = (flip ? 1 : 0) ^ sideToMove;
+
+    auto pawnOrder = [&ix](int a, int b) { return ix.mapPawns[a] < ix.mapPawns[b]; };
+
+    if (table->hasPawns) {
+        // The leading pawns come first in every piece order, so any file tells their color
+        int leader = table->pairs(part, 0, 0).pieces[0] ^ flipColor;
+        Bitboard b = leadPawns = pos.pieces(static_cast<Color>(leader >> 3), PieceType::Pawn);
+        while (b) {
+            squares[size++] = Bitboards::popLsb(b) ^ flipSquares;
+        }
+        leadPawnsCount = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCount, pawnOrder));
+        int file = Bitboards::fileOf(squares[0]);
+        tableFile = file > 3 ? 7 - file : file;
+    }
+
+    // DTZ files store one side to move unless the material is symmetric and pawnless
+    if (dtz) {
+        std::uint8_t flags = table->pairs(part, 0, tableFile).flags;
+        if ((flags & StoresBlackToMove) != stm && !(table->key == table->key2 && !table->hasPawns)) {
+            state = ProbeState::ChangeStm;
+            return 0;
+        }
+    }
+
+    Bitboard b = pos.occupied() ^ leadPawns;
+    while (b) {
+        int square = Bitboards::popLsb(b);
+        squares[size] = square ^ flipSquares;
+        pieces[size++] = pieceCode(pos, square) ^ flipColor;
+    }
+
+    const PairsData& d = table->pairs(part, stm, tableFile);
+
+    // Reorder the pieces to follow the file's piece order
+    for (int i = leadPawnsCount; i < size - 1; i++) {
+        for (int j = i + 1; j < size; j++) {
+            if (d.pieces[i] == pieces[j]) {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    if (Bitboards::fileOf(squares[0]) > 3) {
+        for (int i = 0; i < size; i++) {
+            squares[i] = flipFile(squares[i]);
+        }
+    }
+
+    std::uint64_t idx;
+    if (table->hasPawns) {
+        idx = ix.leadPawnIdx[leadPawnsCount][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawnsCount, pawnOrder);
+        for (int i = 1; i < leadPawnsCount; i++) {
+            idx += ix.binomial[i][ix.mapPawns[squares[i]]];
+        }
+    }
+    else {
+        if (Bitboards::rankOf(squares[0]) > 3) {
+            for (int i = 0; i < size; i++) {
+                squares[i] = flipRank(squares[i]);
+            }
+        }
+
+        // The first leading piece off the a1-h8 diagonal goes below it
+        for (int i = 0; i < d.groupLen[0]; i++) {
+            if (!offDiagonal(squares[i])) continue;
+            if (offDiagonal(squares[i]) > 0) {
+                for (int j = i; j < size; j++) {
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                }
+            }
+            break;
+        }
+
+        if (table->hasUniquePieces) {
+            // Three unique pieces are numbered together; later squares skip the earlier ones
+            int adjust1 = squares[1] > squares[0];
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (offDiagonal(squares[0])) {
+                idx = (ix.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            }
+            else if (offDiagonal(squares[1])) {
+                idx = (6 * 63 + Bitboards::rankOf(squares[0]) * 28 + ix.mapB1H1H7[squares[1]]) * 62
+                    + squares[2] - adjust2;
+            }
+            else if (offDiagonal(squares[2])) {
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + Bitboards::rankOf(squares[0]) * 7 * 28
+                    + (Bitboards::rankOf(squares[1]) - adjust1) * 28 + ix.mapB1H1H7[squares[2]];
+            }
+            else {
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + Bitboards::rankOf(squares[0]) * 7 * 6
+                    + (Bitboards::rankOf(squares[1]) - adjust1) * 6 + (Bitboards::rankOf(squares[2]) - adjust2);
+            }
+        }
+        else {
+            idx = ix.mapKK[ix.mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // Every further group is a combination of squares the earlier groups left free
+    idx *= d.groupIdx[0];
+    int* groupSquares = squares + d.groupLen[0];
+    bool remainingPawns = table->hasPawns && table->pawnCount[1];
+    for (int next = 1; d.groupLen[next]; next++) {
+        std::stable_sort(groupSquares, groupSquares + d.groupLen[next]);
+        std::uint64_t n = 0;
+        for (int i = 0; i < d.groupLen[next]; i++) {
+            int square = groupSquares[i];
+            int adjust = static_cast<int>(std::count_if(squares, groupSquares, [square](int s) { return square > s; }));
+            n += ix.binomial[i + 1][square - adjust - (remainingPawns ? 8 : 0)];
+        }
+        remainingPawns = false;
+        idx += n * d.groupIdx[next];
+        groupSquares += d.groupLen[next];
+    }
+
+    int value = decompressPairs(d, idx);
+    if (!dtz) return value - 2;
+
+    // DTZ values are remapped by frequency per WDL value, and some are stored in moves
+    const PairsData& mapping = table->pairs(part, 0, tableFile);
+    int w = static_cast<int>(wdl);
+    if (mapping.flags & Mapped) {
+        std::size_t at = mapping.mapIdx[WdlToMap[w + 2]] + value;
+        value = mapping.flags & Wide ? readLittleEndian16(part.valueMap + 2 * at) : part.valueMap[at];
+    }
+    if ((wdl == Wdl::Win && !(mapping.flags & WinPlies)) || (wdl == Wdl::Loss && !(mapping.flags & LossPlies))
+        || wdl == Wdl::CursedWin || wdl == Wdl::BlessedLoss) {
+        value *= 2;
+    }
+    return value + 1;
+}
+
+/**
+ * @brief WDL value of the position, resolving the captures the tables leave unstored.
+ *
+ * Where a capture wins, the generator stores whatever compresses best, so the
+ * captures (and pawn moves, for DTZ) are searched and the better of them and the
+ * stored value is the true one.
+ */
+SyzygyTablebases::Wdl SyzygyTablebases::search(Position& pos, bool zeroingMoves, ProbeState& state) const {
+    Wdl best = Wdl::Loss;
+    MoveList moves;
+    MoveGen::generateLegalMoves(pos, pos.sideToMove(), moves);
+    int searched = 0;
+
+    for (int i = 0; i < moves.size(); i++) {
+        Move move = moves[i];
+        bool capture = !pos.isEmpty(move.to()) || move.flag() == MoveFlag::EnPassant;
+        if (!capture && (!zeroingMoves || pos.pieceTypeAt(move.from()) != PieceType::Pawn)) continue;
+        searched++;
+
+        UndoInfo undo;
+        pos.doMove(move, undo);
+        Wdl value = negate(search(pos, false, state));
+        pos.undoMove(move, undo);
+        if (state == ProbeState::Fail) return Wdl::Draw;
+
+        if (value > best) {
+            best = value;
+            if (value >= Wdl::Win) {
+                state = ProbeState::ZeroingBestMove;
+                return value;
+            }
+        }
+    }
+
+    // When every move was searched the stored value, which ignores en passant, is not needed
+    bool noMoreMoves = searched && searched == moves.size();
+    Wdl value;
+    if (noMoreMoves) {
+        value = best;
+    }
+    else {
+        value = static_cast<Wdl>(probeTable(pos, false, Wdl::Draw, state));
+        if (state == ProbeState::Fail) return Wdl::Draw;
+    }
+
+    if (best >= value) {
+        state = best > Wdl::Draw || noMoreMoves ? ProbeState::ZeroingBestMove : ProbeState::Ok;
+        return best;
+    }
+    state = ProbeState::Ok;
+    return value;
+}
+
+int SyzygyTablebases::dtzOf(Position& pos, ProbeState& state) const {
+    state = ProbeState::Ok;
+    Wdl wdl = search(pos, true, state);
+    if (state == ProbeState::Fail || wdl == Wdl::Draw) return 0;
+    if (state == ProbeState::ZeroingBestMove) return dtzBeforeZeroing(wdl);
+
+    int dtz = probeTable(pos, true, wdl, state);
+    if (state == ProbeState::Fail) return 0;
+    if (state != ProbeState::ChangeStm) {
+        return (dtz + (wdl == Wdl::BlessedLoss || wdl == Wdl::CursedWin ? 100 : 0)) * signOf(static_cast<int>(wdl));
+    }
+
+    // Only the other side to move is stored: take the best DTZ one ply further on
+    MoveList moves;
+    MoveGen::generateLegalMoves(pos, pos.sideToMove(), moves);
+    int minDtz = 0xFFFF;
+    for (int i = 0; i < moves.size(); i++) {
+        Move move = moves[i];
+        bool zeroing = isZeroing(pos, move);
+
+        UndoInfo undo;
+        pos.doMove(move, undo);
+        // A zeroing move counts from before it; the value after it only gives the sign
+        dtz = zeroing ? -dtzBeforeZeroing(search(pos, false, state)) : -dtzOf(pos, state);
+        if (dtz == 1 && isMated(pos)) minDtz = 1;
+        if (!zeroing) dtz += signOf(dtz);
+        if (dtz < minDtz && signOf(dtz) == signOf(static_cast<int>(wdl))) minDtz = dtz;
+        pos.undoMove(move, undo);
+
+        if (state == ProbeState::Fail) return 0;
+    }
+    return minDtz == 0xFFFF ? -1 : minDtz;
+}
+
+bool SyzygyTablebases::probeWdl(const Position& position, Wdl& wdl) const {
+    if (!covers(position)) return false;
+    Position pos = position;
+    ProbeState state = ProbeState::Ok;
+    wdl = search(pos, false, state);
+    return state != ProbeState::Fail;
+}
+
+bool SyzygyTablebases::probeDtz(const Position& position, int& dtz) const {
+    if (!covers(position)) return false;
+    Position pos = position;
+    ProbeState state = ProbeState::Ok;
+    dtz = dtzOf(pos, state);
+    return state != ProbeState::Fail;
+}
+
+bool SyzygyTablebases::probeRoot(const Position& position, Move& move, Wdl& wdl, int& dtz) const {
+    if (!probeWdl(position, wdl)) return false;
+
+    Position pos = position;
+    MoveList moves;
+    MoveGen::generateLegalMoves(pos, pos.sideToMove(), moves);
+    const int clock = pos.halfmoveClock();
+    bool found = false;
+    int bestRank = 0;
+
+    for (int i = 0; i < moves.size(); i++) {
+        Move candidate = moves[i];
+        bool zeroing = isZeroing(pos, candidate);
+        ProbeState state = ProbeState::Ok;
+
+        UndoInfo undo;
+        pos.doMove(candidate, undo);
+        int value;
+        if (zeroing) {
+            value = dtzBeforeZeroing(negate(search(pos, false, state)));
+        }
+        else {
+            value = -dtzOf(pos, state);
+            value += signOf(value);
+        }
+        if (value == 2 && isMated(pos)) value = 1;
+        pos.undoMove(candidate, undo);
+        if (state == ProbeState::Fail) return false;
+
+        // Ranked by the value under the fifty-move rule, then quickest win or slowest loss
+        int distance = value < 0 ? -value : value;
+        int rank = static_cast<int>(fiftyMoveWdl(value, clock)) * 1000000 + (value > 0 ? -distance : distance);
+        if (!found || rank > bestRank) {
+            found = true;
+            bestRank = rank;
+            move = candidate;
+            dtz = value;
+        }
+    }
+    if (found) {
+        wdl = fiftyMoveWdl(dtz, clock);
+    }
+    return found;
+}
+
+SyzygyTablebases::Wdl SyzygyTablebases::fiftyMoveWdl(int dtz, int halfmoveClock) {
+    if (dtz == 0) return Wdl::Draw;
+
+    // The zeroing move is played with the clock at halfmoveClock + |dtz| - 1, so it must not have reached 100
+    bool beatsClock = (dtz < 0 ? -dtz : dtz) + halfmoveClock <= 100;
+    if (dtz > 0) return beatsClock ? Wdl::Win : Wdl::CursedWin;
+    return beatsClock ? Wdl::Loss : Wdl::BlessedLoss;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "position.h"
+
+/**
+ * @brief Read-only Syzygy endgame tablebases (.rtbw win/draw/loss and .rtbz distance-to-zero files).
+ *
+ * Opening only scans the directories for table files; each file is memory-mapped
+ * and its header decoded the first time a probe needs it. Positions with castling
+ * rights are never in the tables. Probing never modifies the tables and is safe
+ * from any number of threads.
+ */
+class SyzygyTablebases {
+public:
+    /**
+     * @brief Game-theoretic value for the side to move. Cursed wins and blessed losses
+     * are only won or lost if the fifty-move rule is ignored.
+     */
+    enum class Wdl {
+        Loss = -2,
+        BlessedLoss = -1,
+        Draw = 0,
+        CursedWin = 1,
+        Win = 2
+    };
+
+    struct Settings {
+        std::string path;       ///< Directories of table files, separated by ';' on Windows and ':' elsewhere; empty for none.
+        int maxPieces = 0;      ///< Only probe positions with at most this many pieces, kings included; 0 for as many as the tables cover.
+    };
+
+    SyzygyTablebases();
+    ~SyzygyTablebases();
+
+    SyzygyTablebases(const SyzygyTablebases&) = delete;
+    SyzygyTablebases& operator=(const SyzygyTablebases&) = delete;
+
+    /**
+     * @brief Finds the table files, replacing any tables already open.
+     * @return false if no .rtbw file was found.
+     */
+    bool open(const Settings& settings);
+    void close();
+
+    bool isOpen() const { return !tables_.empty(); }
+
+    /// Number of material combinations with a win/draw/loss table.
+    std::size_t size() const { return tables_.size(); }
+
+    /// Largest piece count a probe is attempted for.
+    int maxPieces() const { return maxPieces_; }
+
+    /**
+     * @brief Whether the position is small enough to probe and has no castling rights.
+     */
+    bool covers(const Position& position) const;
+
+    /**
+     * @return false if a needed table is missing or corrupt.
+     */
+    bool probeWdl(const Position& position, Wdl& wdl) const;
+
+    /**
+     * @brief Plies to the next capture or pawn move with best play, signed like the WDL value.
+     *
+     * Cursed wins and blessed losses are reported 100 plies further away, so a
+     * magnitude above 100 means the fifty-move rule draws the game. 0 is a draw.
+     * @return false if a needed table is missing or corrupt.
+     */
+    bool probeDtz(const Position& position, int& dtz) const;
+
+    /**
+     * @brief The tablebase-optimal move given the position's halfmove clock: the quickest win
+     * that still beats the fifty-move rule, then the quickest win it draws, then a draw, then
+     * a loss it saves, otherwise the longest resistance.
+     * @param wdl Value of the position before the move, for the side to move, as fiftyMoveWdl gives it.
+     * @param dtz Distance to zeroing after the move, counted from before it.
+     * @return false if the position is not covered, has no legal move, or a needed table is missing.
+     */
+    bool probeRoot(const Position& position, Move& move, Wdl& wdl, int& dtz) const;
+
+    /**
+     * @brief Value of a position with the given distance to zeroing once its halfmove clock is counted.
+     *
+     * A win or loss whose zeroing move comes after the clock reaches 100 is drawn by the
+     * fifty-move rule, so it becomes a cursed win or blessed loss.
+     * @param dtz As probeDtz reports it.
+     * @param halfmoveClock Plies played since the last capture or pawn move.
+     */
+    static Wdl fiftyMoveWdl(int dtz, int halfmoveClock);
+
+private:
+    struct Table;
+    enum class ProbeState;
+
+    Wdl search(Position& position, bool zeroingMoves, ProbeState& state) const;
+    int probeTable(const Position& position, bool dtz, Wdl wdl, ProbeState& state) const;
+    int dtzOf(Position& position, ProbeState& state) const;
+    Table* tableFor(const Position& position, bool dtz) const;
+
+    std::vector<std::unique_ptr<Table>> tables_;
+    std::unordered_map<std::uint64_t, Table*> byMaterial_;
+    int largestTable_;
+    int maxPieces_;
+};
@@ -0,0 +1,158 @@
+#include "syzygyTablebases.h"
+#include "fen.h"
+#include <iostream>
+#include <string>
+
+/**
+ * Syzygy probing regression gate.
+ *
+ * Usage:
+ *   syzygyTest [--path <directory of table files>]
+ *
+ * Always checks how the fifty-move clock turns distances to zeroing into results.
+ * With --path it also probes real tables: KQvK, KRvK, KBvK, KNvK, KPvK, KBNvK and
+ * KRPvKR, both .rtbw and .rtbz, which fetchSyzygy.py downloads. Those checks cover
+ * 3 to 5 piece positions whose value follows from the rules alone (mates,
+ * stalemate, promotion, insufficient material and textbook endings), some of them
+ * with the clock close to 100. Exits non-zero if a table is missing or a value is wrong.
+ */
+
+namespace {
+    using Wdl = SyzygyTablebases::Wdl;
+
+    /// Expected distance to zeroing for positions where it is not checked.
+    const int AnyDtz = -1000;
+
+    struct FiftyMoveCase {
+        int dtz;
+        int halfmoveClock;
+        Wdl wdl;
+    };
+
+    /// Distances as probeDtz reports them, with cursed wins and blessed losses 100 plies further away.
+    const FiftyMoveCase FiftyMoveCases[] = {
+        { 0, 0, Wdl::Draw },
+        { 0, 99, Wdl::Draw },
+        { 1, 99, Wdl::Win },            // Mate or zeroing move played with the clock at 99
+        { 1, 100, Wdl::CursedWin },     // The game is drawn before it
+        { 100, 0, Wdl::Win },
+        { 100, 1, Wdl::CursedWin },
+        { 60, 40, Wdl::Win },
+        { 60, 41, Wdl::CursedWin },
+        { 101, 0, Wdl::CursedWin },     // Cursed in the tables whatever the clock
+        { 120, 0, Wdl::CursedWin },
+        { -2, 98, Wdl::Loss },
+        { -2, 99, Wdl::BlessedLoss },
+        { -100, 0, Wdl::Loss },
+        { -60, 41, Wdl::BlessedLoss },
+        { -101, 0, Wdl::BlessedLoss },
+    };
+
+    struct ReferencePosition {
+        const char* name;
+        const char* fen;
+        Wdl wdl;            ///< As the tables store it, without the halfmove clock.
+        int dtz;            ///< AnyDtz if not checked.
+        bool root;          ///< Also check what probeRoot reports for its move.
+        Wdl clockWdl;       ///< With the FEN's halfmove clock counted; checked along with dtz.
+    };
+
+    const ReferencePosition ReferencePositions[] = {
+        { "KQvK mate in one", "7k/8/6K1/8/8/8/8/1Q6 w - - 0 1", Wdl::Win, 1, true, Wdl::Win },
+        { "KQvK mate in one, clock 99", "7k/8/6K1/8/8/8/8/1Q6 w - - 99 80", Wdl::Win, 1, true, Wdl::Win },
+        { "KQvK mate in one, clock 100", "7k/8/6K1/8/8/8/8/1Q6 w - - 100 80", Wdl::Win, 1, true, Wdl::CursedWin },
+        { "KQvK mated in one", "7k/8/6K1/8/8/8/8/1Q6 b - - 0 1", Wdl::Loss, -2, true, Wdl::Loss },
+        { "KQvK mated in one, clock 99", "7k/8/6K1/8/8/8/8/1Q6 b - - 99 80", Wdl::Loss, -2, true, Wdl::BlessedLoss },
+        { "KQvK checkmated", "1Q5k/8/6K1/8/8/8/8/8 b - - 1 1", Wdl::Loss, AnyDtz, false, Wdl::Loss },
+        { "KQvK stalemate", "k7/8/1Q6/8/8/8/8/7K b - - 0 1", Wdl::Draw, 0, false, Wdl::Draw },
+        { "KPvK promotion", "8/4P3/8/8/8/8/k7/4K3 w - - 0 1", Wdl::Win, 1, true, Wdl::Win },
+        { "KPvK rook pawn", "k7/8/8/8/8/8/P7/4K3 w - - 0 1", Wdl::Draw, 0, false, Wdl::Draw },
+        { "KRvK", "8/8/8/8/4k3/8/8/R3K3 w - - 0 1", Wdl::Win, AnyDtz, false, Wdl::Win },
+        { "KRvK defending", "8/8/8/8/4k3/8/8/R3K3 b - - 0 1", Wdl::Loss, AnyDtz, false, Wdl::Loss },
+        { "KNvK", "8/8/8/4k3/8/8/8/N3K3 w - - 0 1", Wdl::Draw, 0, false, Wdl::Draw },
+        { "KBNvK", "8/8/8/4k3/8/8/8/2B1KN2 w - - 0 1", Wdl::Win, AnyDtz, false, Wdl::Win },
+        { "KRPvKR Lucena", "1K1k4/1P6/8/8/8/8/r7/2R5 w - - 0 1", Wdl::Win, AnyDtz, false, Wdl::Win },
+    };
+
+    bool checkFiftyMove(const FiftyMoveCase& reference, std::string& detail) {
+        Wdl wdl = SyzygyTablebases::fiftyMoveWdl(reference.dtz, reference.halfmoveClock);
+        detail = "wdl " + std::to_string(static_cast<int>(wdl));
+        return wdl == reference.wdl;
+    }
+
+    bool check(const SyzygyTablebases& tablebases, const ReferencePosition& reference, std::string& detail) {
+        Position position;
+        int fullmoveNumber;
+        if (Fen::parse(reference.fen, position, fullmoveNumber) != Fen::Error::None) {
+            detail = "bad FEN";
+            return false;
+        }
+
+        Wdl wdl;
+        if (!tablebases.probeWdl(position, wdl)) {
+            detail = "WDL probe failed";
+            return false;
+        }
+        detail = "wdl " + std::to_string(static_cast<int>(wdl));
+        if (wdl != reference.wdl) return false;
+
+        if (reference.dtz != AnyDtz) {
+            int dtz;
+            if (!tablebases.probeDtz(position, dtz)) {
+                detail += ", DTZ probe failed";
+                return false;
+            }
+            detail += ", dtz " + std::to_string(dtz);
+            if (dtz != reference.dtz) return false;
+            if (SyzygyTablebases::fiftyMoveWdl(dtz, position.halfmoveClock()) != reference.clockWdl) return false;
+        }
+
+        if (reference.root) {
+            Move move;
+            Wdl rootWdl;
+            int rootDtz;
+            if (!tablebases.probeRoot(position, move, rootWdl, rootDtz)) {
+                detail += ", root probe failed";
+                return false;
+            }
+            detail += ", root " + move.toUci() + " wdl " + std::to_string(static_cast<int>(rootWdl)) + " dtz " + std::to_string(rootDtz);
+            if (rootWdl != reference.clockWdl || rootDtz != reference.dtz) return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    SyzygyTablebases::Settings settings;
+    if (argc == 3 && std::string(argv[1]) == "--path") {
+        settings.path = argv[2];
+    }
+    else if (argc != 1) {
+        std::cerr << "usage: syzygyTest [--path <directory of table files>]" << std::endl;
+        return 2;
+    }
+
+    int failures = 0;
+    for (const auto& reference : FiftyMoveCases) {
+        std::string detail;
+        bool ok = checkFiftyMove(reference, detail);
+        if (!ok) failures++;
+        std::cout << (ok ? "[ OK ] " : "[FAIL] ") << "dtz " << reference.dtz << " at clock " << reference.halfmoveClock
+            << " (" << detail << ")" << std::endl;
+    }
+    if (settings.path.empty()) return failures == 0 ? 0 : 1;
+
+    SyzygyTablebases tablebases;
+    if (!tablebases.open(settings)) {
+        std::cout << "[FAIL] no tables in " << settings.path << std::endl;
+        return 1;
+    }
+
+    for (const auto& reference : ReferencePositions) {
+        std::string detail;
+        bool ok = check(tablebases, reference, detail);
+        if (!ok) failures++;
+        std::cout << (ok ? "[ OK ] " : "[FAIL] ") << reference.name << " (" << detail << ")" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+#include "uci.h"
+#include <charconv>
+
+namespace {
+    /**
+     * @brief Splits a line into whitespace-separated tokens in place.
+     */
+    class TokenReader {
+    public:
+        explicit TokenReader(std::string_view text) : text_(text) {}
+
+        bool next(std::string_view& token) {
+            const char* current = text_.data();
+            const char* end = current + text_.size();
+            while (current != end && (*current == ' ' || *current == '\t')) current++;
+            if (current == end) return false;
+
+            const char* start = current;
+            while (current != end && *current != ' ' && *current != '\t') current++;
+
+            token = std::string_view(start, static_cast<std::size_t>(current - start));
+            text_ = std::string_view(current, static_cast<std::size_t>(end - current));
+            return true;
+        }
+
+        template<typename Integer>
+        bool nextNumber(Integer& value) {
+            std::string_view token;
+            if (!next(token)) return false;
+            auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+            return result.ec == std::errc() && result.ptr == token.data() + token.size();
+        }
+
+    private:
+        std::string_view text_;
+    };
+
+    bool parseSquare(char file, char rank, int& square) {
+        if (file < 'a' || file > 'h' || rank < '1' || rank > '8') return false;
+        square = (rank - '1') * 8 + (file - 'a');
+        return true;
+    }
+}
+
+bool Uci::parseMove(std::string_view text, Move& move) {
+    if (text.size() != 4 && text.size() != 5) return false;
+
+    int from, to;
+    if (!parseSquare(text[0], text[1], from) || !parseSquare(text[2], text[3], to)) return false;
+
+    if (text.size() == 4) {
+        move = Move(from, to);
+        return true;
+    }
+
+    PieceType promotion;
+    switch (text[4]) {
+    case 'n': promotion = PieceType::Knight; break;
+    case 'b': promotion = PieceType::Bishop; break;
+    case 'r': promotion = PieceType::Rook; break;
+    case 'q': promotion = PieceType::Queen; break;
+    default: return false;
+    }
+    move = Move(from, to, MoveFlag::Promotion, promotion);
+    return true;
+}
+
+bool Uci::parseInfo(std::string_view line, Info& info) {
+    TokenReader reader(line);
+    std::string_view token;
+    if (!reader.next(token) || token != "info") return false;
+
+    info = Info();
+    while (reader.next(token)) {
+        if (token == "depth") reader.nextNumber(info.depth);
+        else if (token == "seldepth") reader.nextNumber(info.seldepth);
+        else if (token == "multipv") reader.nextNumber(info.multipv);
+        else if (token == "nodes") reader.nextNumber(info.nodes);
+        else if (token == "nps") reader.nextNumber(info.nps);
+        else if (token == "hashfull") reader.nextNumber(info.hashfull);
+        else if (token == "time") reader.nextNumber(info.timeMs);
+        else if (token == "score") {
+            if (!reader.next(token)) break;
+            info.mate = token == "mate";
+            info.hasScore = reader.nextNumber(info.score);
+        }
+        else if (token == "lowerbound") info.bound = Bound::Lower;
+        else if (token == "upperbound") info.bound = Bound::Upper;
+        else if (token == "pv") {
+            // The pv runs to the end of the line
+            Move move;
+            while (reader.next(token) && info.pvLength < MaxPvLength && parseMove(token, move)) {
+                info.pv[info.pvLength++] = move;
+            }
+            break;
+        }
+        else if (token == "string") {
+            // Free text for humans, with nothing to decode
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Uci::parseBestMove(std::string_view line, BestMove& bestMove) {
+    TokenReader reader(line);
+    std::string_view token;
+    if (!reader.next(token) || token != "bestmove") return false;
+
+    bestMove = BestMove();
+    if (reader.next(token)) {
+        // "(none)" when there was no legal move leaves move empty
+        parseMove(token, bestMove.move);
+    }
+    if (reader.next(token) && token == "ponder" && reader.next(token)) {
+        parseMove(token, bestMove.ponder);
+    }
+    return true;
+}
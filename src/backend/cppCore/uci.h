@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include "move.h"
+
+/**
+ * @brief Decoding of the UCI lines an engine prints while it searches.
+ *
+ * Everything works on string_view and fills fixed-size structs, so parsing a
+ * line never touches the heap.
+ */
+namespace Uci {
+
+    /// Longer principal variations are truncated.
+    constexpr int MaxPvLength = 64;
+
+    enum class Bound : std::uint8_t {
+        Exact, Lower, Upper
+    };
+
+    /**
+     * @brief One "info" line. Fields the engine did not send keep their defaults.
+     */
+    struct Info {
+        int depth = 0;
+        int seldepth = 0;
+        int multipv = 1;            ///< 1-based rank of the line when searching several.
+        bool hasScore = false;
+        bool mate = false;          ///< score is moves to mate (negative when getting mated) rather than centipawns.
+        int score = 0;
+        Bound bound = Bound::Exact;
+        std::uint64_t nodes = 0;
+        std::uint64_t nps = 0;
+        int hashfull = 0;           ///< Hash table use in permille.
+        int timeMs = 0;
+        int pvLength = 0;
+        Move pv[MaxPvLength];
+    };
+
+    /**
+     * @brief A "bestmove" line. move is none when the engine had no legal move.
+     */
+    struct BestMove {
+        Move move;
+        Move ponder;                ///< None when the engine sent no ponder move.
+    };
+
+    /**
+     * @brief Parses a move in long algebraic notation, e.g. "e2e4" or "e7e8q".
+     *
+     * Without the position at hand castling and en passant cannot be told apart
+     * from normal moves, so those come back with MoveFlag::Normal; toUci() still
+     * reproduces the original text.
+     */
+    bool parseMove(std::string_view text, Move& move);
+
+    /**
+     * @brief Parses an "info" line. Returns false for other lines and for "info string".
+     */
+    bool parseInfo(std::string_view line, Info& info);
+
+    /**
+     * @brief Parses a "bestmove" line. Returns false for other lines.
+     */
+    bool parseBestMove(std::string_view line, BestMove& bestMove);
+}
@@ -1,15 +1,63 @@
 #include "utility.h"
 
+#include <cerrno>
+#include <cstddef>
 #include <fstream>
-#include <map>
+#include <stdexcept>
+#include <system_error>
 
-int Utility::read_port_from_env(const std::string& filename) {
+#ifdef _WIN32
+#include <windows.h>
+#include <bcrypt.h>
+#else
+#include <sys/random.h>
+#endif
+
+namespace {
+    /**
+     * @brief Fills buffer from the operating system's cryptographic random generator.
+     * @throws std::runtime_error if the generator fails.
+     */
+    void fillRandom(unsigned char* buffer, std::size_t size) {
+#ifdef _WIN32
+        if (!BCRYPT_SUCCESS(BCryptGenRandom(NULL, buffer, static_cast<ULONG>(size), BCRYPT_USE_SYSTEM_PREFERRED_RNG))) {
+            throw std::runtime_error("BCryptGenRandom failed");
+        }
+#else
+        while (size > 0) {
+            ssize_t read = getrandom(buffer, size, 0);
+            if (read < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "getrandom");
+            }
+            buffer += read;
+            size -= static_cast<std::size_t>(read);
+        }
+#endif
+    }
+}
+
+std::string Utility::read_env(const std::string& name, const std::string& filename) {
     std::ifstream file(filename);
+    std::string prefix = name + "=";
     std::string line;
     while (std::getline(file, line)) {
-        if (line.find("PORT=") == 0) {
-            return std::stoi(line.substr(5));
+        if (line.compare(0, prefix.size(), prefix) == 0) {
+            return line.substr(prefix.size());
         }
     }
-    return 1337; // default
-}
\ No newline at end of file
+    return std::string();
+}
+
+std::string Utility::generate_id() {
+    unsigned char bytes[16];
+    fillRandom(bytes, sizeof(bytes));
+
+    static const char Hex[] = "0123456789abcdef";
+    std::string id(2 * sizeof(bytes), '0');
+    for (std::size_t i = 0; i < sizeof(bytes); i++) {
+        id[2 * i] = Hex[bytes[i] >> 4];
+        id[2 * i + 1] = Hex[bytes[i] & 15];
+    }
+    return id;
+}
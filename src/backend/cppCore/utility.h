@@ -1,6 +1,7 @@
 #pragma once
 
 #include <sstream>
+#include <string>
 /**
  * @brief Provides reusable utility functions
  *
@@ -9,10 +10,22 @@
 class Utility {
 public:
     /**
-	 * @brief Gets the port from the environtment variable.
-	 * @param filename The file contains the environment variable,
-	 * default is ".env"
-	 * @return The port number.
-	 */
-	static int read_port_from_env(const std::string& filename = ".env");
+     * @brief Gets a variable from the environment file.
+     * @param name The variable, as written before the '=' sign.
+     * @param filename The file contains the environment variables,
+     * default is ".env"
+     * @return Everything after the '=' sign, empty if the variable is unset.
+     */
+    static std::string read_env(const std::string& name, const std::string& filename = ".env");
+
+    /**
+     * @brief Generates an opaque 32 hex digit id.
+     *
+     * Ids are 128 bits from the operating system's cryptographic generator
+     * (getrandom, or BCryptGenRandom on Windows), so holding some ids tells
+     * nothing about others; game ids are the only guard on the game routes.
+     * Collisions are negligible at this size.
+     * @throws std::runtime_error if the generator fails.
+     */
+    static std::string generate_id();
 };
\ No newline at end of file
@@ -0,0 +1,4 @@
+#include "zobrist.h"
+
+// Constant-initialized: the keys are baked into the binary and usable during static initialization
+constexpr Zobrist::Keys Zobrist::keys{};
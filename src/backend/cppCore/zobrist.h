@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Zobrist hashing keys.
+ *
+ * A position key is the XOR of one key per (color, piece, square), one key for
+ * the castling rights, one for the en passant file when a capture is possible
+ * and one when Black is to move. The keys are generated at compile time from a
+ * fixed seed, so they are identical across runs and builds.
+ */
+namespace Zobrist {
+
+    struct Keys {
+        std::uint64_t pieces[2][6][64];
+        std::uint64_t castling[16];
+        std::uint64_t enPassant[8];
+        std::uint64_t blackToMove;
+
+        constexpr Keys() : pieces(), castling(), enPassant(), blackToMove() {
+            std::uint64_t state = 0x6A09E667F3BCC908ULL;
+            for (int color = 0; color < 2; color++) {
+                for (int type = 0; type < 6; type++) {
+                    for (int square = 0; square < 64; square++) {
+                        pieces[color][type][square] = next(state);
+                    }
+                }
+            }
+            for (int i = 0; i < 16; i++) castling[i] = next(state);
+            for (int i = 0; i < 8; i++) enPassant[i] = next(state);
+            blackToMove = next(state);
+        }
+
+    private:
+        // splitmix64
+        static constexpr std::uint64_t next(std::uint64_t& state) {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+    };
+
+    extern const Keys keys;
+}